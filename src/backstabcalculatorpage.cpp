@@ -256,35 +256,27 @@ void BackstabCalculatorPage::Private::updateCurrentSeries()
     const int index = tabs->currentIndex();
     const Ui::BackstabSetup& setup = setups[index];
     const WeaponArrangement weapon = setup.weapon->toData();
-    // TODO: luck support
-    // FIXME: this line is copy/pasted from damage calculator page. Also, this
-    // line is like the only outside use of physicalDamageType(), and shows
-    // that physicalDamage() is not that useful if it returns a copy that
-    // we can't use to modify the luck value. Should be easy to fix.
-    // weapon.damage.find(weapon.physicalDamageType()).value().luck(42);
-
-    const bool max = setup.maximumDamage->isChecked();
-    double totalWeaponDamage = 0.0;
-    for (const auto& damage : weapon.damage)
-        totalWeaponDamage += (max ? damage.maximum() : damage.average());
-    const DiceRoll physicalDamage = weapon.physicalDamage();
-    const double physicalPart = (max ? physicalDamage.maximum() : physicalDamage.average())
-                              + setup.kit->value() + setup.other->value();
-
-    // TODO: use this in a testable way instead of the quick solution. :-)
+
     Backstab::Other other;
     other.strength = setup.strength->value();
     other.multiplier = setup.multiplier->value();
     other.kit = setup.kit->value();
     other.bonus = setup.other->value();
-    const Backstab calculator(weapon, other);
-
-    const int remainingMultiplier = other.multiplier - 1;
+    other.luck = setup.luck->value();
+    other.maximumDamage = setup.maximumDamage->isChecked();
+    const BackstabResult result = calculateBackstab(Backstab(weapon, other));
 
+    // The averages, split in what gets added once and the rest of the multiplied part.
+    const double multiplied = (other.multiplier - 1) * result.multipliedMean;
     setStrength->replace(index, other.strength);
-    setBase->replace(index, totalWeaponDamage);
-    setMultiplied->replace(index, remainingMultiplier * physicalPart);
-    qDebug() << setup.name->text() << totalWeaponDamage << (remainingMultiplier*physicalPart);
+    setBase->replace(index, result.mean - other.strength - multiplied);
+    setMultiplied->replace(index, multiplied);
+
+    setup.statistics->setText(tr("Minimum: %1, average: %2, maximum: %3\n"
+                                 "Percentiles 10th: %4, 50th: %5, 90th: %6")
+                              .arg(result.minimum).arg(result.mean, 0, 'f', 2)
+                              .arg(result.maximum).arg(result.percentile(0.1))
+                              .arg(result.percentile(0.5)).arg(result.percentile(0.9)));
 
     setupAxes();
 }
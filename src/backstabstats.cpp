@@ -1,10 +1,43 @@
 #include "backstabstats.h"
 
-BackstabResult calculateBackstab(const BackstabInput& input)
+using namespace Calculators;
+
+BackstabResult calculateBackstab(const Backstab& backstab)
 {
-    const auto m = input.multiplier;
-    return BackstabResult {
-        .weapon = m * (input.weapon.maximum()),
-        .other  = m * (input.proficiency + input.style + input.kit + input.other)
-    };
+    const Backstab::Other& other = backstab.other;
+    // Luck only changes the physical damage, like in the damage calculator. The
+    // maximum damage is +20 luck, like Kai there, but for all the dice.
+    const int luck = other.luck + (other.maximumDamage ? 20 : 0);
+
+    const WeaponArrangement& weapon = backstab.weapon;
+    DiceRoll physical = weapon.physicalDamage();
+    physical.luck(physical.luck() + luck);
+    const Distribution weaponDamage = physical.distribution();
+
+    // The kit and other bonuses only come with the extra hits of the multiplier
+    // (multiplier - 1 times), not with the base hit of the weapon.
+    const int multiplier = other.multiplier;
+    const int bonuses = other.kit + other.bonus;
+    Distribution total = weaponDamage.mapped([multiplier](int value) {
+        return value * multiplier;
+    }).shifted((multiplier - 1) * bonuses);
+    for (auto entry = weapon.damage.constBegin(), last = weapon.damage.constEnd();
+         entry != last; ++entry)
+    {
+        if (entry.key() & DamageType::ElementalBit) {
+            DiceRoll roll = entry.value();
+            roll.luck(roll.luck() + (other.maximumDamage ? 20 : 0));
+            total = total.convolved(roll.distribution());
+        }
+    }
+    total = total.shifted(other.strength);
+
+    BackstabResult result;
+    result.cumulative = CumulativeDistribution(total);
+    result.minimum = total.first();
+    result.maximum = total.last();
+    result.mean = total.mean();
+    result.multipliedMean = weaponDamage.mean() + bonuses;
+    result.distribution = std::move(total);
+    return result;
 }
@@ -1,23 +1,33 @@
 #pragma once
 
-#include <QtGlobal>
-
-#include "diceroll.h"
-
-struct BackstabInput
-{
-    quint8 multiplier;
-    DiceRoll weapon;
-    quint8 proficiency;
-    quint8 style;
-    quint8 kit;
-    quint8 other;
-};
+#include "calculators.h"
+#include "distribution.h"
 
+/*!
+ * \brief Statistics of the damage of one backstab
+ *
+ * From the whole distribution of the dice, not just the maximum. The same
+ * parts as the backstab page always had: the base hit is the damage of the
+ * weapon, physical (with its luck) and elemental, plus the strength bonus. The
+ * multiplier adds (multiplier - 1) times the physical damage plus the kit and
+ * other bonuses.
+ */
 struct BackstabResult
 {
-    int weapon;
-    int other;
+    /// Probability of each value of the total damage.
+    Distribution distribution;
+    CumulativeDistribution cumulative;
+    int minimum = 0;
+    int maximum = 0;
+    double mean = 0.0;
+    /// The average of what each extra hit of the multiplier adds: the physical
+    /// damage, and the kit and other bonuses.
+    double multipliedMean = 0.0;
+
+    /// The damage at the given percentile, e.g. 0.5 for the median.
+    int percentile(double probability) const { return cumulative.quantile(probability); }
+    /// Probability of killing with one backstab a creature with \a hitPoints.
+    double killChance(int hitPoints) const { return cumulative.probabilityAtLeast(hitPoints); }
 };
 
-BackstabResult calculateBackstab(const BackstabInput& input);
+BackstabResult calculateBackstab(const Calculators::Backstab& backstab);
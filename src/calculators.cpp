@@ -19,9 +19,29 @@
 #include "calculators.h"
 
 #include <QDebug>
+#include <QtMath>
+
+#include <array>
+#include <numeric>
+#include <utility>
 
 using namespace Calculators;
 
+RoundSchedule RoundSchedule::of(double attacks)
+{
+    Q_ASSERT(attacks >= 0.0);
+    const int halves = qRound(attacks * 2);
+    if (halves <= Detail::HalvesInTables && qAbs(attacks * 2 - halves) < 1e-9)
+        return Detail::halfSchedules[halves];
+    // The smallest denominator that gives the number exactly, or the biggest.
+    for (int denominator = 1; denominator < MaximumPeriod; ++denominator) {
+        const int numerator = qRound(attacks * denominator);
+        if (qAbs(attacks * denominator - numerator) < 1e-9)
+            return RoundSchedule(numerator, denominator);
+    }
+    return RoundSchedule(qRound(attacks * MaximumPeriod), MaximumPeriod);
+}
+
 DiceRoll WeaponArrangement::physicalDamage() const
 {
     Q_ASSERT(damage.contains(physicalDamageType()));
@@ -32,11 +52,10 @@ DiceRoll WeaponArrangement::physicalDamage() const
 
 DamageType WeaponArrangement::physicalDamageType() const
 {
-    for (auto entry = damage.constBegin(), last = damage.constEnd(); entry != last; ++entry) {
-        const DamageType type = entry.key();
-        if (type < DamageType::ElementalBit)
-            return type;
-    }
+    // The physical types are the lowest bits of the mask.
+    const uint physical = damage.mask() & DamageMap<DiceRoll>::PhysicalMask;
+    if (physical != 0)
+        return DamageMap<DiceRoll>::typeAt(std::countr_zero(physical));
     Q_UNREACHABLE();
     return DamageType::Crushing;
 }
@@ -70,13 +89,41 @@ QPair<int, int> Damage::hitDistribution(Hand hand, int ac) const
     return result;
 }
 
+QVector<QPair<int, int>> Damage::hitTable(Hand hand, int acFrom, int acTo) const
+{
+    const WeaponArrangement& arrangement = hand == One ? m_1 : m_2;
+    return hitTable(thac0(hand), arrangement.criticalHit, arrangement.criticalMiss, acFrom, acTo);
+}
+
+// The same rules as hit(), but counting the rolls of each kind: the criticals
+// are the ones from criticalHitRoll up, and the regular hits the rest from the
+// highest of the critical miss and the roll to hit, which is the only part that
+// depends on the armor class.
+QVector<QPair<int, int>> Damage::hitTable(int thac0, int criticalHit, int criticalMiss,
+                                          int acFrom, int acTo)
+{
+    const int criticalHitRoll = qMax(1, 21 - (criticalHit/5));
+    const int criticals = qMax(0, 21 - criticalHitRoll);
+    const int lowestHit = qMax(1, criticalMiss/5 + 1);
+    const int highestHit = qMin(20, criticalHitRoll - 1);
+
+    const int step = acFrom <= acTo ? 1 : -1;
+    QVector<QPair<int, int>> result;
+    result.reserve(qAbs(acTo - acFrom) + 1);
+    for (int ac = acFrom; ac != acTo + step; ac += step) {
+        const int regular = highestHit - qMax(lowestHit, thac0 - ac) + 1;
+        result.append({qMax(0, regular), criticals});
+    }
+    return result;
+}
+
 int Damage::thac0(Damage::Hand hand) const
 {
     const WeaponArrangement& arrangement = hand == One ? m_1 : m_2;
     return m_common.thac0 - m_common.toHitBonuses() - arrangement.toHitBonuses();
 }
 
-QHash<DamageType, double> Damage::onHitDamages(Damage::Hand hand, Damage::Stat stat) const
+DamageMap<double> Damage::onHitDamages(Damage::Hand hand, Damage::Stat stat) const
 {
     const WeaponArrangement& arrangement = hand == One ? m_1 : m_2;
     DiceRoll physicalDamageRoll = arrangement.physicalDamage();
@@ -84,7 +131,7 @@ QHash<DamageType, double> Damage::onHitDamages(Damage::Hand hand, Damage::Stat s
 
     const double physicalDamage = physicalDamageRoll.average() * (stat == Regular ? 1 : 2);
 
-    QHash<DamageType, double> result;
+    DamageMap<double> result;
     for (auto entry = arrangement.damage.constBegin(), last = arrangement.damage.constEnd();
          entry != last; ++entry)
     {
@@ -110,3 +157,229 @@ double Damage::onHitDamage(Hand hand, Stat stat) const
     return result;
 }
 
+
+Distribution Damage::onHitDistribution(Hand hand, Stat stat) const
+{
+    const WeaponArrangement& arrangement = hand == One ? m_1 : m_2;
+    DiceRoll physicalDamageRoll = arrangement.physicalDamage();
+    physicalDamageRoll.bonus(physicalDamageRoll.bonus() + m_common.damageBonuses());
+
+    Distribution physicalDamage = physicalDamageRoll.distribution();
+    if (stat == Critical)
+        physicalDamage = physicalDamage.mapped([](int value) { return value * 2; });
+
+    // Same as onHitDamages(), but adding (convolving) each type of damage.
+    Distribution result;
+    for (auto entry = arrangement.damage.constBegin(), last = arrangement.damage.constEnd();
+         entry != last; ++entry)
+    {
+        const DamageType type = entry.key();
+        if (type & DamageType::ElementalBit)
+            result = result.convolved(entry.value().distribution());
+        else // Physical damage.
+            result = result.convolved(physicalDamage);
+    }
+    return result;
+}
+
+Distribution Damage::attackDistribution(Hand hand, int ac, Stat critical) const
+{
+    const auto [regular, criticals] = hitDistribution(hand, ac);
+    const int hits = regular + criticals;
+    if (hits == 0)
+        return Distribution();
+    const Distribution onHit = onHitDistribution(hand, Regular)
+            .mixed(double(regular) / hits, onHitDistribution(hand, critical));
+    return onHit.mixed(hits / 20.0);
+}
+
+Distribution Damage::roundDistribution(Hand hand, int ac, Stat critical) const
+{
+    return roundDistributions(hand, {ac}, critical).constFirst();
+}
+
+// A round of n attacks is a multinomial over the attacks that miss, hit and
+// hit critically, so it's the mix of the damages of j regular hits plus k
+// critical ones, with the probability of getting exactly those hits. A
+// fractional number of attacks is one more mix, of n and n+1 attacks.
+QVector<Distribution> Damage::roundDistributions(Hand hand, const QVector<int>& armorClasses,
+                                                 Stat critical) const
+{
+    const double attacks = arrangement(hand).attacks;
+    Q_ASSERT(attacks >= 0.0);
+    const int fewer = qFloor(attacks);
+    const double fraction = attacks - fewer;
+    const int most = qFuzzyIsNull(fraction) ? fewer : fewer + 1;
+
+    const Distribution regular = onHitDistribution(hand, Regular);
+    const Distribution doubled = onHitDistribution(hand, critical);
+    QVector<Distribution> regularPowers = {Distribution()};
+    QVector<Distribution> criticalPowers = {Distribution()};
+    for (int n = 1; n <= most; ++n) {
+        regularPowers.append(regularPowers.constLast().convolved(regular));
+        criticalPowers.append(criticalPowers.constLast().convolved(doubled));
+    }
+    // combined[j][k] is the damage of j regular hits and k critical ones.
+    QVector<QVector<Distribution>> combined(most + 1);
+    for (int j = 0; j <= most; ++j) {
+        for (int k = 0; j + k <= most; ++k)
+            combined[j].append(regularPowers.at(j).convolved(criticalPowers.at(k)));
+    }
+
+    auto binomial = [](int n, int k) {
+        double result = 1.0;
+        for (int i = 1; i <= k; ++i)
+            result = result * (n - k + i) / i;
+        return result;
+    };
+
+    QVector<Distribution> result;
+    result.reserve(armorClasses.size());
+    for (const int ac : armorClasses) {
+        const auto [regulars, criticals] = hitDistribution(hand, ac);
+        const double hit = regulars / 20.0;
+        const double criticalHit = criticals / 20.0;
+        const double miss = (20 - regulars - criticals) / 20.0;
+
+        // Probability of j regular hits and k critical ones in n attacks.
+        auto probability = [&](int n, int j, int k) {
+            if (j + k > n)
+                return 0.0;
+            return binomial(n, j) * binomial(n - j, k) * qPow(hit, j) * qPow(criticalHit, k)
+                 * qPow(miss, n - j - k);
+        };
+
+        // Each mix adds one more term with its share of the total weight so far.
+        Distribution round;
+        double total = 0.0;
+        for (int j = 0; j <= most; ++j) {
+            for (int k = 0; j + k <= most; ++k) {
+                double weight = (1.0 - fraction) * probability(fewer, j, k);
+                if (most > fewer)
+                    weight += fraction * probability(most, j, k);
+                if (weight <= 0.0)
+                    continue;
+                total += weight;
+                round = combined.at(j).at(k).mixed(weight / total, round);
+            }
+        }
+        result.append(round);
+    }
+    return result;
+}
+
+Distribution Damage::roundDistribution(int ac1, int ac2, Stat critical) const
+{
+    return roundDistribution(One, ac1, critical).convolved(roundDistribution(Two, ac2, critical));
+}
+
+QVector<Distribution> Damage::roundCycle(Hand hand, int ac, Stat critical) const
+{
+    const RoundSchedule schedule = RoundSchedule::of(arrangement(hand).attacks);
+    const Distribution attack = attackDistribution(hand, ac, critical);
+    QVector<Distribution> result;
+    result.reserve(schedule.period());
+    for (int round = 0; round < schedule.period(); ++round)
+        result.append(attack.power(schedule.attacks(round)));
+    return result;
+}
+
+QVector<Distribution> Damage::roundCycle(int ac1, int ac2, Stat critical) const
+{
+    const QVector<Distribution> one = roundCycle(One, ac1, critical);
+    const QVector<Distribution> two = roundCycle(Two, ac2, critical);
+    const int period = std::lcm(one.size(), two.size());
+    QVector<Distribution> result;
+    result.reserve(period);
+    for (int round = 0; round < period; ++round)
+        result.append(one.at(round % one.size()).convolved(two.at(round % two.size())));
+    return result;
+}
+
+Distribution Damage::roundsDistribution(Hand hand, int ac, int rounds, Stat critical) const
+{
+    Q_ASSERT(rounds >= 0);
+    const RoundSchedule schedule = RoundSchedule::of(arrangement(hand).attacks);
+    return attackDistribution(hand, ac, critical).power(schedule.totalAttacks(rounds));
+}
+
+namespace
+{
+
+template <bool OffHand, bool DoubleCritical, bool CriticalStrike, bool MaximumDamage>
+QVector<double> averageDamagesKernel(const Damage& input, const Damage::Sweep& sweep)
+{
+    const auto adjusted = [](WeaponArrangement weapon) {
+        if constexpr (CriticalStrike)
+            weapon.criticalHit = 100;
+        if constexpr (MaximumDamage) {
+            DiceRoll& roll = weapon.damage[weapon.physicalDamageType()];
+            roll.luck(roll.luck() + 20);
+        }
+        return weapon;
+    };
+    const Damage damage(adjusted(input.arrangement(Damage::One)),
+                        adjusted(input.arrangement(Damage::Two)), input.common());
+
+    constexpr Damage::Stat critical = DoubleCritical ? Damage::Critical : Damage::Regular;
+    const double attacks1 = RoundSchedule::of(damage.arrangement(Damage::One).attacks).average();
+    // Damage per roll of the die to hit, so only the count of rolls is left.
+    const double regular1 = attacks1 * damage.onHitDamage(Damage::One, Damage::Regular) / 20;
+    const double critical1 = attacks1 * damage.onHitDamage(Damage::One, critical) / 20;
+    double regular2 = 0.0, critical2 = 0.0;
+    if constexpr (OffHand) {
+        const double attacks2 = RoundSchedule::of(damage.arrangement(Damage::Two).attacks).average();
+        regular2 = attacks2 * damage.onHitDamage(Damage::Two, Damage::Regular) / 20;
+        critical2 = attacks2 * damage.onHitDamage(Damage::Two, critical) / 20;
+    }
+
+    const int size = qAbs(sweep.acTo - sweep.acFrom) + 1;
+    QVector<double> result(size);
+    if constexpr (CriticalStrike) {
+        // All the rolls are critical hits, whatever the armor class.
+        result.fill(20 * (critical1 + critical2));
+        return result;
+    }
+
+    const auto table1 = damage.hitTable(Damage::One, sweep.acFrom - sweep.acModifier1,
+                                        sweep.acTo - sweep.acModifier1);
+    QVector<QPair<int, int>> table2;
+    if constexpr (OffHand) {
+        table2 = damage.hitTable(Damage::Two, sweep.acFrom - sweep.acModifier2,
+                                 sweep.acTo - sweep.acModifier2);
+    }
+    for (int index = 0; index < size; ++index) {
+        const auto [hits1, criticals1] = table1.at(index);
+        double value = hits1 * regular1 + criticals1 * critical1;
+        if constexpr (OffHand) {
+            const auto [hits2, criticals2] = table2.at(index);
+            value += hits2 * regular2 + criticals2 * critical2;
+        }
+        result[index] = value;
+    }
+    return result;
+}
+
+using AverageDamagesKernel = QVector<double> (*)(const Damage&, const Damage::Sweep&);
+
+// Indexed by the switches as bits: offHand the lowest, maximumDamage the highest.
+template <std::size_t... Indexes>
+constexpr std::array<AverageDamagesKernel, sizeof...(Indexes)>
+averageDamagesKernels(std::index_sequence<Indexes...>)
+{
+    return {&averageDamagesKernel<bool(Indexes & 1), bool(Indexes & 2),
+                                  bool(Indexes & 4), bool(Indexes & 8)>...};
+}
+
+constexpr auto s_averageDamagesKernels = averageDamagesKernels(std::make_index_sequence<16>());
+
+}
+
+QVector<double> Damage::averageDamages(const Sweep& sweep) const
+{
+    const int index = int(sweep.offHand)
+                    | int(sweep.doubleCriticalDamage) << 1
+                    | int(sweep.criticalStrike) << 2
+                    | int(sweep.maximumDamage) << 3;
+    return s_averageDamagesKernels[index](*this, sweep);
+}
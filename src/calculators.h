@@ -18,10 +18,17 @@
 
 #pragma once
 
-#include <QHash>
 #include <QMetaType>
+#include <QPair>
 
 #include "diceroll.h"
+#include "distribution.h"
+
+#include <array>
+#include <bit>
+#include <initializer_list>
+#include <type_traits>
+#include <utility>
 
 namespace Calculators
 {
@@ -47,6 +54,198 @@ enum DamageType
     // effect in many weapons ("get poisoned" vs "direct poison damage").
 };
 
+/*!
+ * \brief Map from each DamageType to a value, stored inline
+ *
+ * The types are a small dense set, so each one has its own slot in a fixed
+ * array (the physical ones first, at 0-3, then the elemental ones), and a
+ * bitmask tells which of them are present. Copying or looking up doesn't
+ * allocate nor hash, and iterating goes in the order of the slots.
+ *
+ * The API is the subset of QHash that the calculators use.
+ */
+template <typename T>
+class DamageMap
+{
+    template <bool Const>
+    class Iterator
+    {
+        using Map = std::conditional_t<Const, const DamageMap, DamageMap>;
+        using Reference = std::conditional_t<Const, const T&, T&>;
+    public:
+        explicit Iterator(Map* map, int index) : m_map(map), m_index(index) {}
+
+        DamageType key() const { return DamageMap::typeAt(m_index); }
+        Reference value() const { return m_map->m_values[m_index]; }
+        Reference operator*() const { return value(); }
+        Iterator& operator++() { m_index = m_map->next(m_index + 1); return *this; }
+        bool operator==(const Iterator& other) const { return m_index == other.m_index; }
+        bool operator!=(const Iterator& other) const { return m_index != other.m_index; }
+
+    private:
+        Map* m_map;
+        int m_index;
+    };
+
+public:
+    static constexpr int Size = 10;
+    static constexpr quint16 PhysicalMask = 0b1111;
+
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    static constexpr int indexOf(DamageType type)
+    {
+        return type & ElementalBit ? type - ElementalBit + 4 : type;
+    }
+    static constexpr DamageType typeAt(int index)
+    {
+        return DamageType(index < 4 ? index : index - 4 + ElementalBit);
+    }
+
+    DamageMap() : m_values() {}
+    DamageMap(std::initializer_list<std::pair<DamageType, T>> list)
+        : DamageMap()
+    {
+        for (const auto& [type, value] : list)
+            insert(type, value);
+    }
+
+    bool contains(DamageType type) const { return m_present & bit(type); }
+    bool isEmpty() const { return m_present == 0; }
+    int size() const { return std::popcount(uint(m_present)); }
+    /// Bitmask of the present types, one bit for the index of each.
+    quint16 mask() const { return m_present; }
+
+    T value(DamageType type, const T& defaultValue = T()) const
+    {
+        return contains(type) ? m_values[indexOf(type)] : defaultValue;
+    }
+    void insert(DamageType type, const T& value)
+    {
+        m_values[indexOf(type)] = value;
+        m_present |= bit(type);
+    }
+    /// Like in QHash, a default constructed value is inserted if missing.
+    T& operator[](DamageType type)
+    {
+        m_present |= bit(type);
+        return m_values[indexOf(type)];
+    }
+
+    iterator begin() { return iterator(this, next(0)); }
+    iterator end() { return iterator(this, Size); }
+    const_iterator begin() const { return constBegin(); }
+    const_iterator end() const { return constEnd(); }
+    const_iterator constBegin() const { return const_iterator(this, next(0)); }
+    const_iterator constEnd() const { return const_iterator(this, Size); }
+
+private:
+    static constexpr quint16 bit(DamageType type) { return quint16(1u << indexOf(type)); }
+
+    // The first index present from \a from, or Size if there is none.
+    int next(int from) const
+    {
+        const uint rest = uint(m_present) & (~0u << from);
+        return rest == 0 ? Size : std::countr_zero(rest);
+    }
+
+    std::array<T, Size> m_values;
+    quint16 m_present = 0;
+};
+
+static_assert(DamageMap<int>::indexOf(PoisonDamage) == DamageMap<int>::Size - 1);
+static_assert(DamageMap<int>::typeAt(DamageMap<int>::indexOf(Fire)) == Fire);
+
+/*!
+ * \brief The attacks of each round, for a number of attacks per round that can
+ * be fractional
+ *
+ * There are no fractional attacks in a round: with 1.5 attacks per round, one
+ * round has 1 attack, the next 2, and so on. The round r (from 0) has
+ * floor((r+1)*attacks) - floor(r*attacks), which repeats in a cycle of as many
+ * rounds as the denominator of the fraction (up to MaximumPeriod, otherwise
+ * it's rounded to that denominator).
+ *
+ * The values that the game uses (halves, from 0 to 10) are precomputed at
+ * compile time, and the schedule is stored inline, so getting one for each
+ * value of a sweep doesn't allocate.
+ */
+class RoundSchedule
+{
+public:
+    static constexpr int MaximumPeriod = 12;
+
+    constexpr RoundSchedule() = default;
+    constexpr RoundSchedule(int numerator, int denominator)
+    {
+        Q_ASSERT(numerator >= 0 && denominator >= 1 && denominator <= MaximumPeriod);
+        // The period is the denominator of the reduced fraction.
+        int a = numerator, b = denominator;
+        while (b != 0) {
+            const int rest = a % b;
+            a = b;
+            b = rest;
+        }
+        m_period = denominator / (a == 0 ? denominator : a);
+        const int reduced = numerator / (denominator / m_period);
+        for (int round = 0; round < m_period; ++round)
+            m_attacks[round] = (round + 1) * reduced / m_period - round * reduced / m_period;
+    }
+
+    /// The schedule of \a attacks per round, from the tables if possible.
+    static RoundSchedule of(double attacks);
+
+    constexpr int period() const { return m_period; }
+    /// Attacks in round \a round, counting from 0.
+    constexpr int attacks(int round) const { return m_attacks[round % m_period]; }
+    /// Attacks in the first \a rounds rounds.
+    constexpr int totalAttacks(int rounds) const
+    {
+        int result = rounds / m_period * sum();
+        for (int round = 0; round < rounds % m_period; ++round)
+            result += m_attacks[round];
+        return result;
+    }
+    /// The (exact) average of attacks per round.
+    constexpr double average() const { return double(sum()) / m_period; }
+
+private:
+    constexpr int sum() const
+    {
+        int result = 0;
+        for (int round = 0; round < m_period; ++round)
+            result += m_attacks[round];
+        return result;
+    }
+
+    std::array<int, MaximumPeriod> m_attacks = {};
+    int m_period = 1;
+};
+
+namespace Detail
+{
+
+constexpr int HalvesInTables = 20;
+
+constexpr std::array<RoundSchedule, HalvesInTables + 1> makeHalfSchedules()
+{
+    std::array<RoundSchedule, HalvesInTables + 1> result = {};
+    for (int halves = 0; halves <= HalvesInTables; ++halves)
+        result[halves] = RoundSchedule(halves, 2);
+    return result;
+}
+
+inline constexpr auto halfSchedules = makeHalfSchedules();
+
+}
+
+static_assert(Detail::halfSchedules[3].period() == 2);
+static_assert(Detail::halfSchedules[3].attacks(0) == 1 && Detail::halfSchedules[3].attacks(1) == 2);
+static_assert(Detail::halfSchedules[4].period() == 1 && Detail::halfSchedules[4].attacks(7) == 2);
+static_assert(RoundSchedule(5, 2).totalAttacks(3) == 7);
+static_assert(RoundSchedule(4, 3).totalAttacks(3) == 4);
+
 /*!
  * \brief Struct mapping the inputs in WeaponArrangementWidget
  */
@@ -58,7 +257,7 @@ struct WeaponArrangement {
     int proficiencyDamage = 0;
 
     // Each damage roll is purely from the weapon.
-    QHash<DamageType, DiceRoll> damage;
+    DamageMap<DiceRoll> damage;
     double attacks = 1.0;
     int criticalHit = 5;
     int criticalMiss = 5;
@@ -80,6 +279,8 @@ struct Backstab {
         int kit = 0;
         int bonus = 0;
         int strength = 0;
+        int luck = 0;
+        bool maximumDamage = false;
     };
 
     explicit Backstab(WeaponArrangement weapon_, Backstab::Other other_)
@@ -109,6 +310,22 @@ public:
         int damageBonuses() const { return statDamage + otherDamage; }
     };
 
+    // The switches of the damage calculator, and the range of armor classes
+    // to sweep, for averageDamages().
+    struct Sweep {
+        int acFrom = 10;
+        int acTo = -20;
+        // Bonus to the AC of the enemy against the physical damage of each
+        // hand (see WeaponArrangement::physicalDamageType()).
+        int acModifier1 = 0;
+        int acModifier2 = 0;
+
+        bool offHand = false;
+        bool doubleCriticalDamage = true; // False when wearing a helmet.
+        bool criticalStrike = false; // Every hit is critical.
+        bool maximumDamage = false; // Kai or Righteous Magic: +20 luck to physical damage.
+    };
+
     explicit Damage(const WeaponArrangement& one, const WeaponArrangement& two,
                     const Damage::Common& common)
         : m_1(one)
@@ -124,12 +341,55 @@ public:
     // Returns how many rolls should be a normal or a critical hit (in the 1-20
     // range). No need to return the failures, because those are the remaining.
     QPair<int, int> hitDistribution(Hand hand, int ac) const;
+    // The same for each armor class from \a acFrom to \a acTo (both included,
+    // in that order, which can be descending), without looping over the rolls.
+    QVector<QPair<int, int>> hitTable(Hand hand, int acFrom, int acTo) const;
+    // The same, from the parts of the arrangement that matter for hitting.
+    static QVector<QPair<int, int>> hitTable(int thac0, int criticalHit, int criticalMiss,
+                                             int acFrom, int acTo);
     // TODO: The name is not too good as the THAC0 should be used only for base THAC0.
     // But effectively, this is the number to hit AC 0, once modifiers are applied.
     int thac0(Hand hand) const;
-    QHash<DamageType, double> onHitDamages(Hand hand, Stat stat) const;
+    const WeaponArrangement& arrangement(Hand hand) const { return hand == One ? m_1 : m_2; }
+    const Damage::Common& common() const { return m_common; }
+    DamageMap<double> onHitDamages(Hand hand, Stat stat) const;
     double onHitDamage(Hand hand, Stat stat) const;
 
+    // The same as the above, but the whole distribution of the damage instead
+    // of the average. The resistances are the ones set in each DiceRoll.
+    Distribution onHitDistribution(Hand hand, Stat stat) const;
+    // One attack against \a ac: 0 when it misses, the regular damage when it
+    // hits, and the damage of \a critical on a critical hit.
+    Distribution attackDistribution(Hand hand, int ac, Stat critical = Critical) const;
+    // All the attacks of a round of \a hand. A fractional number of attacks
+    // (e.g. 1.5) alternates the rounds with the attacks rounded down and up,
+    // so it's a mix of both with the weight of the fractional part.
+    Distribution roundDistribution(Hand hand, int ac, Stat critical = Critical) const;
+    // The same for each of \a armorClasses. Much cheaper than calling the
+    // above for each one, as the damage of each combination of hits doesn't
+    // depend on the armor class, and gets calculated only once.
+    QVector<Distribution> roundDistributions(Hand hand, const QVector<int>& armorClasses,
+                                             Stat critical = Critical) const;
+    // A round with both hands, against \a ac1 and \a ac2 respectively (which
+    // can be different because of the AC modifiers against the damage type).
+    Distribution roundDistribution(int ac1, int ac2, Stat critical = Critical) const;
+
+    // The rounds with the exact number of attacks of each (see RoundSchedule),
+    // instead of the mix of roundDistribution(). The distribution of each
+    // round of one cycle of the schedule of \a hand, which then repeats.
+    QVector<Distribution> roundCycle(Hand hand, int ac, Stat critical = Critical) const;
+    // The same with both hands, so the cycle is as long as both schedules.
+    QVector<Distribution> roundCycle(int ac1, int ac2, Stat critical = Critical) const;
+    // The total damage of the first \a rounds rounds of \a hand.
+    Distribution roundsDistribution(Hand hand, int ac, int rounds,
+                                    Stat critical = Critical) const;
+
+    // The average damage per round (with the average number of attacks of the
+    // schedule) against each armor class from \a sweep.acFrom to acTo, both
+    // included. Each combination of switches is a separate instantiation of
+    // the loop, so they are not checked for each armor class.
+    QVector<double> averageDamages(const Sweep& sweep) const;
+
 private:
     WeaponArrangement m_1, m_2;
     Damage::Common m_common;
@@ -24,6 +24,7 @@
 #include "ui_weaponarrangementwidget.h"
 
 #include "calculators.h"
+#include "damagegraph.h"
 #include "diceroll.h"
 
 // TODO: make their own pages.
@@ -43,6 +44,7 @@
 #include <QJsonObject>
 #include <QLegendMarker>
 #include <QLineSeries>
+#include <QLoggingCategory>
 #include <QMenu>
 #include <QMenuBar>
 #include <QScrollBar>
@@ -67,6 +69,8 @@ using namespace Calculators;
 using namespace QtCharts;
 #endif
 
+Q_LOGGING_CATEGORY(lcDamageCalculator, "damagecalculator", QtWarningMsg);
+
 static const auto keyDamageCalculations = QStringLiteral("DamageCalculations");
 static const auto keyDamageCalculator   = QStringLiteral("DamageCalculator");
 
@@ -228,6 +232,8 @@ struct DamageCalculatorPage::Private
     QTabWidget* tabs = nullptr;
 
     QVector<Calculation> calculations;
+    // One for each calculation, with what was computed for the last update.
+    QVector<DamageGraph> graphs;
     QVector<QLineSeries*> lineSeries;
     QVector<QVariantHash> savedCalculations;
 
@@ -528,7 +534,7 @@ struct DamageCalculatorPage::Private
 
     void updateAllSeries() {
         for (int index = 0; index < tabs->count(); ++index) {
-            updateSeries(calculations[index], lineSeries[index]);
+            updateSeries(index);
         }
     }
     // TODO: previously this accepted the index as parameter, which is better,
@@ -536,16 +542,15 @@ struct DamageCalculatorPage::Private
     // causing a crash when deleting tabs. But I will have to support something
     // if I want to allow moving tabs around.
     void updateSeriesAtCurrentIndex() {
-        const int index = tabs->currentIndex();
-        updateSeries(calculations[index], lineSeries[index]);
+        updateSeries(tabs->currentIndex());
     }
 
     // The widget class has a simple function to serialize itself (toData()),
-    // but Luck and Critical Strike are globally set, so we pass them to have a
+    // but Luck is globally set, so we pass it to have a
     // simple wrapper that allows us to be built as const and never modify them.
-    WeaponArrangement makeArrangement(WeaponArrangementWidget* widget, int luck, bool criticalStrike) const;
-    QVector<QPointF> pointsFromInput(const Calculation& c) const;
-    void updateSeries(const Calculation& c, QLineSeries* series);
+    WeaponArrangement makeArrangement(WeaponArrangementWidget* widget, int luck) const;
+    QVector<QPointF> pointsFromInput(const Calculation& c, DamageGraph& graph) const;
+    void updateSeries(int index);
 
     static void setColorInButton(const QColor& color, QPushButton* button)
     {
@@ -861,6 +866,7 @@ DamageCalculatorPage::DamageCalculatorPage(QWidget* parent)
         if (d->tabs->count() == 1)
             return; // don't close the last one for now, to keep the "New" button
         d->calculations.removeAt(index);
+        d->graphs.removeAt(index);
         d->chart->removeSeries(d->lineSeries[index]);
         delete d->lineSeries.takeAt(index);
         // TODO: with the new approach, this might be a tad heavy. Review.
@@ -1146,6 +1152,7 @@ void DamageCalculatorPage::Private::newPage()
     auto widget = new QWidget;
 
     calculations.append(Calculation());
+    graphs.append(DamageGraph());
     Calculation& calculation = calculations.last();
     calculation.setupUi(widget);
     tabs->addTab(widget, tr("Calculation %1").arg(tabs->count() + 1));
@@ -1280,39 +1287,30 @@ void DamageCalculatorPage::Private::setupAxes()
 }
 
 WeaponArrangement DamageCalculatorPage::Private::makeArrangement(WeaponArrangementWidget* widget,
-                                                                 int luck, bool criticalStrike) const
+                                                                 int luck) const
 {
     // This does most of the work, missing only the parts not on WeaponArrangementWidget
+    // (Critical Strike and maximum damage are switches of Damage::averageDamages()).
     WeaponArrangement result = widget->toData();
-    if (criticalStrike)
-        result.criticalHit = 100;
-
-    result.damage.find(result.physicalDamageType()).value().luck(luck);
+    result.damage[result.physicalDamageType()].luck(luck);
 
-    for (auto entry = result.damage.keyValueBegin(),
-         last = result.damage.keyValueEnd(); entry != last; ++entry)
+    for (auto entry = result.damage.begin(), last = result.damage.end(); entry != last; ++entry)
     {
-        const Calculators::DamageType type = entry.base().key();
-        DiceRoll& roll = entry.base().value();
+        const Calculators::DamageType type = entry.key();
+        DiceRoll& roll = entry.value();
         roll.resistance(enemy.resistanceFactor(type));
     }
 
     return result;
 }
 
-QVector<QPointF> DamageCalculatorPage::Private::pointsFromInput(const Calculation& c) const
+QVector<QPointF> DamageCalculatorPage::Private::pointsFromInput(const Calculation& c,
+                                                                DamageGraph& graph) const
 {
-    const bool doubleCriticalDamage = !enemy.helmet->isChecked();
-    const bool offHand = c.offHandGroup->isChecked();
-    const bool maximumDamage = c.maximumDamage->isChecked();
-    const bool criticalStrike = c.criticalStrike->isChecked();
-    // Kai and Righteous Magic apply +20 to effect #250 ("Damage Modifier"), like luck.
-    const int luck = c.luck->value() + (maximumDamage ? 20 : 0);
-
     // TODO: support damage resistance over 100%, which should obviously heal
     // a creature, and hence subtract from the total damage.
-    const WeaponArrangement weapon1 = makeArrangement(c.weapon1, luck, criticalStrike);
-    const WeaponArrangement weapon2 = makeArrangement(c.weapon2, luck, criticalStrike);
+    const WeaponArrangement weapon1 = makeArrangement(c.weapon1, c.luck->value());
+    const WeaponArrangement weapon2 = makeArrangement(c.weapon2, c.luck->value());
 
     Damage::Common common;
     common.thac0 = c.baseThac0->value();
@@ -1322,51 +1320,41 @@ QVector<QPointF> DamageCalculatorPage::Private::pointsFromInput(const Calculatio
     common.statDamage = c.statDamageBonus->value();
     common.otherDamage = c.classDamageBonus->value() + c.miscDamageBonus->value();
 
-    const int acModifier1 = enemy.acModifier(weapon1.physicalDamageType());
-    const int acModifier2 = enemy.acModifier(weapon2.physicalDamageType());
-
-    const Damage calculator(weapon1, weapon2, common);
+    Damage::Sweep sweep;
+    sweep.acFrom = armorClasses.first();
+    sweep.acTo = armorClasses.last();
+    sweep.acModifier1 = enemy.acModifier(weapon1.physicalDamageType());
+    sweep.acModifier2 = enemy.acModifier(weapon2.physicalDamageType());
+    sweep.offHand = c.offHandGroup->isChecked();
+    sweep.doubleCriticalDamage = !enemy.helmet->isChecked();
+    sweep.criticalStrike = c.criticalStrike->isChecked();
+    // Kai and Righteous Magic apply +20 to effect #250 ("Damage Modifier"), like luck.
+    sweep.maximumDamage = c.maximumDamage->isChecked();
 
     // TODO: The aggregated values are the only ones that we really use, but it
     // has always been in my mind to chart the distribution of the details. Like
     // a 2nd chart with the % of damage coming from criticals, elements, etc.
-    const Damage::Stat criticalStat = doubleCriticalDamage ? Damage::Critical : Damage::Regular;
-#if 0
-    const auto damages1R = calculator.onHitDamages(Damage::One, Damage::Regular);
-    const auto damages2R = calculator.onHitDamages(Damage::Two, Damage::Regular);
-    const auto damages1C = calculator.onHitDamages(Damage::One, criticalStat);
-    const auto damages2C = calculator.onHitDamages(Damage::Two, criticalStat);
-#endif
-    const double damage1R = calculator.onHitDamage(Damage::One, Damage::Regular);
-    const double damage2R = calculator.onHitDamage(Damage::Two, Damage::Regular);
-    const double damage1C = calculator.onHitDamage(Damage::One, criticalStat);
-    const double damage2C = calculator.onHitDamage(Damage::Two, criticalStat);
-
+    // The graph only recomputes what depends on the inputs that changed.
+    graph.setArrangement(Damage::One, weapon1);
+    graph.setArrangement(Damage::Two, weapon2);
+    graph.setCommon(common);
+    graph.setSweep(sweep);
+    const QVector<double>& damages = graph.averageDamages();
+    qCDebug(lcDamageCalculator) << "Recomputed" << graph.recomputedNodes()
+                                << "of" << DamageGraph::NodeCount << "nodes";
+
+    // The armor classes are a contiguous range, so the damages match them by index.
     QVector<QPointF> points;
-    for (const int ac : armorClasses) {
-        const int ac1 = ac - acModifier1;
-        const int ac2 = ac - acModifier2;
-
-        // TODO: Move the last math remainings to the calculator, and unit test that.
-        const auto distribution1 = calculator.hitDistribution(Damage::One, ac1);
-        const auto distribution2 = calculator.hitDistribution(Damage::Two, ac2);
-        const double regularDmg1 = distribution1.first  * damage1R;
-        const double regularDmg2 = distribution2.first  * damage2R;
-        const double doubledDmg1 = distribution1.second * damage1C;
-        const double doubledDmg2 = distribution2.second * damage2C;
-
-        double damage = weapon1.attacks * (regularDmg1 + doubledDmg1)/20;
-        if (offHand)
-            damage   += weapon2.attacks * (regularDmg2 + doubledDmg2)/20;
-
-        points.append(QPointF(ac, damage));
-    }
+    points.reserve(damages.size());
+    for (int index = 0, size = armorClasses.size(); index < size; ++index)
+        points.append(QPointF(armorClasses.at(index), damages.at(index)));
     return points;
 }
 
-void DamageCalculatorPage::Private::updateSeries(const Calculation& c, QLineSeries* series)
+void DamageCalculatorPage::Private::updateSeries(int index)
 {
-    series->replace(pointsFromInput(c));
+    QLineSeries* series = lineSeries[index];
+    series->replace(pointsFromInput(calculations[index], graphs[index]));
     setupAxes();
     chartRefresher.start(1000);
 
@@ -0,0 +1,383 @@
+/*
+ * This file is part of Moebius Toolkit.
+ * Copyright (C) 2026 Alejandro Exojo Piqueras
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "damageexpression.h"
+
+#include <map>
+#include <tuple>
+
+using namespace Calculators;
+
+namespace
+{
+    const struct {
+        DamageType type;
+        const char* name;
+    } typeNames[] = {
+        {DamageType::Crushing, "crushing"},
+        {DamageType::Missile, "missile"},
+        {DamageType::Piercing, "piercing"},
+        {DamageType::Slashing, "slashing"},
+        {DamageType::Acid, "acid"},
+        {DamageType::Cold, "cold"},
+        {DamageType::Electricity, "electricity"},
+        {DamageType::Fire, "fire"},
+        {DamageType::MagicDamage, "magic"},
+        {DamageType::PoisonDamage, "poison"},
+    };
+
+    // The nodes are added after the ones they depend on, so evaluating them in
+    // order is evaluating the graph. Adding a node equal to an existing one
+    // returns the existing one instead, so the result is not necessarily the
+    // last node, and is set explicitly.
+    class Graph
+    {
+    public:
+        enum Kind {Roll, Mixture, Power, Sum};
+
+        struct Node
+        {
+            Kind kind = Roll;
+            DiceRoll roll; // Roll
+            double probability = 1.0; // Mixture
+            int times = 1; // Power
+            int a = -1, b = -1; // The inputs of the others
+        };
+
+        int addRoll(const DiceRoll& roll)
+        {
+            Node node;
+            node.roll = roll;
+            return add(node);
+        }
+
+        int addMixture(int a, double probability)
+        {
+            Node node;
+            node.kind = Mixture;
+            node.probability = probability;
+            node.a = a;
+            return add(node);
+        }
+
+        int addPower(int a, int times)
+        {
+            Node node;
+            node.kind = Power;
+            node.times = times;
+            node.a = a;
+            return add(node);
+        }
+
+        int addSum(int a, int b)
+        {
+            Node node;
+            node.kind = Sum;
+            node.a = a;
+            node.b = b;
+            return add(node);
+        }
+
+        const QVector<Node>& nodes() const { return m_nodes; }
+
+        void setResult(int id) { m_result = id; }
+
+        Distribution evaluate() const
+        {
+            if (m_result == -1)
+                return Distribution();
+
+            QVector<Distribution> values;
+            values.reserve(m_nodes.size());
+            for (const Node& node : m_nodes) {
+                switch (node.kind) {
+                case Roll:
+                    values.append(node.roll.distribution());
+                    break;
+                case Mixture:
+                    values.append(values.at(node.a).mixed(node.probability));
+                    break;
+                case Power:
+                    values.append(values.at(node.a).power(node.times));
+                    break;
+                case Sum:
+                    values.append(values.at(node.a).convolved(values.at(node.b)));
+                    break;
+                }
+            }
+            return values.at(m_result);
+        }
+
+    private:
+        int add(const Node& node)
+        {
+            const Key key(node.kind, node.roll.number(), node.roll.sides(), node.roll.bonus(),
+                          node.roll.luck(), node.roll.resistance(), node.probability,
+                          node.times, node.a, node.b);
+            const auto found = m_ids.find(key);
+            if (found != m_ids.end())
+                return found->second;
+            m_nodes.append(node);
+            m_ids.emplace(key, m_nodes.size() - 1);
+            return m_nodes.size() - 1;
+        }
+
+        using Key = std::tuple<int, int, int, int, int, double, double, int, int, int>;
+        QVector<Node> m_nodes;
+        std::map<Key, int> m_ids;
+        int m_result = -1;
+    };
+
+    Graph compile(const QVector<DamageExpression::Term>& terms,
+                  const DamageExpression::Resistances& resistances)
+    {
+        Graph graph;
+        // How many times each different term appears.
+        std::map<int, int> counts;
+        for (const DamageExpression::Term& term : terms) {
+            DiceRoll roll = term.roll.probability(1.0);
+            if (term.type)
+                roll.resistance(resistances.value(*term.type, 0.0));
+            int id = graph.addRoll(roll);
+            if (term.roll.probability() < 1.0)
+                id = graph.addMixture(id, term.roll.probability());
+            ++counts[id];
+        }
+
+        int result = -1;
+        for (const auto& [id, times] : counts) {
+            const int term = times == 1 ? id : graph.addPower(id, times);
+            result = result == -1 ? term : graph.addSum(result, term);
+        }
+        graph.setResult(result);
+        return graph;
+    }
+
+    // A small recursive descent parser over the text, which is short. Each
+    // function consumes what it recognizes, and returns false on errors.
+    class Parser
+    {
+    public:
+        explicit Parser(const QString& text) : m_text(text) {}
+
+        bool parse(QVector<DamageExpression::Term>& terms)
+        {
+            skipSpaces();
+            if (atEnd())
+                return true; // Nothing is no damage, and a valid one.
+            do {
+                DamageExpression::Term term;
+                if (!parseTerm(term))
+                    return false;
+                terms.append(term);
+                skipSpaces();
+            } while (consume(QLatin1Char('+')));
+            return atEnd();
+        }
+
+    private:
+        bool parseTerm(DamageExpression::Term& term)
+        {
+            skipSpaces();
+            int number = 1;
+            const bool hasNumber = parseNumber(number);
+            if (consume(QLatin1Char('d')) || consume(QLatin1Char('D'))) {
+                int sides = 0;
+                if (!parseNumber(sides) || sides < 1)
+                    return false;
+                term.roll.number(number).sides(sides);
+                // The bonus goes right after the dice. With spaces around the
+                // sign, it's a term of its own, like any other constant. If
+                // more dice follow the sign (e.g. "1d8+1d6"), it's the start
+                // of the next term instead.
+                if (peek() == QLatin1Char('+') || peek() == QLatin1Char('-')) {
+                    const int sign = peek() == QLatin1Char('-') ? -1 : 1;
+                    const int start = m_position++;
+                    int bonus = 0;
+                    const bool hasBonus = parseNumber(bonus);
+                    if (peek() == QLatin1Char('d') || peek() == QLatin1Char('D'))
+                        m_position = start;
+                    else if (!hasBonus)
+                        return false;
+                    else
+                        term.roll.bonus(sign * bonus);
+                }
+            }
+            else if (hasNumber)
+                term.roll.number(0).bonus(number);
+            else
+                return false;
+
+            skipSpaces();
+            if (consume(QLatin1Char('['))) {
+                QString name;
+                while (!atEnd() && peek() != QLatin1Char(']'))
+                    name += m_text.at(m_position++);
+                if (!consume(QLatin1Char(']')))
+                    return false;
+                if (!parseType(name.trimmed().toLower(), term))
+                    return false;
+                skipSpaces();
+            }
+            if (consume(QLatin1Char('@'))) {
+                skipSpaces();
+                int percent = 0;
+                if (!parseNumber(percent) || percent > 100)
+                    return false;
+                skipSpaces();
+                if (!consume(QLatin1Char('%')))
+                    return false;
+                term.roll.probability(percent / 100.0);
+            }
+            return true;
+        }
+
+        bool parseType(const QString& name, DamageExpression::Term& term)
+        {
+            for (const auto& entry : typeNames) {
+                if (name == QLatin1String(entry.name)) {
+                    term.type = entry.type;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        bool parseNumber(int& result)
+        {
+            const int start = m_position;
+            qint64 value = 0;
+            while (!atEnd() && m_text.at(m_position).isDigit() && value <= 1000000)
+                value = value * 10 + m_text.at(m_position++).digitValue();
+            if (m_position == start || value > 1000000)
+                return false;
+            result = int(value);
+            return true;
+        }
+
+        void skipSpaces()
+        {
+            while (!atEnd() && m_text.at(m_position).isSpace())
+                ++m_position;
+        }
+
+        bool consume(QChar character)
+        {
+            if (peek() != character)
+                return false;
+            ++m_position;
+            return true;
+        }
+
+        QChar peek() const { return atEnd() ? QChar() : m_text.at(m_position); }
+        bool atEnd() const { return m_position >= m_text.size(); }
+
+        const QString& m_text;
+        int m_position = 0;
+    };
+}
+
+DamageExpression::DamageExpression(const QVector<Term>& terms)
+    : m_terms(terms)
+{
+}
+
+DamageExpression DamageExpression::fromString(const QString& text, bool* ok)
+{
+    QVector<Term> terms;
+    const bool parsed = Parser(text).parse(terms);
+    if (ok)
+        *ok = parsed;
+    return parsed ? DamageExpression(terms) : DamageExpression();
+}
+
+DamageExpression DamageExpression::fromArrangement(const WeaponArrangement& arrangement)
+{
+    QVector<Term> terms;
+    for (auto entry = arrangement.damage.constBegin(), last = arrangement.damage.constEnd();
+         entry != last; ++entry)
+    {
+        const DamageType type = entry.key();
+        const bool elemental = type & DamageType::ElementalBit;
+        terms.append({elemental ? entry.value() : arrangement.physicalDamage(), type});
+    }
+    return DamageExpression(terms);
+}
+
+QString DamageExpression::toString() const
+{
+    QString result;
+    for (const Term& term : m_terms) {
+        if (!result.isEmpty())
+            result += QLatin1String(" + ");
+        const DiceRoll& roll = term.roll;
+        if (roll.number() == 0)
+            result += QString::number(roll.bonus());
+        else {
+            result += QString::number(roll.number()) + QLatin1Char('d')
+                    + QString::number(roll.sides());
+            if (roll.bonus() > 0)
+                result += QLatin1Char('+') + QString::number(roll.bonus());
+            else if (roll.bonus() < 0)
+                result += QString::number(roll.bonus());
+        }
+        if (term.type)
+            result += QLatin1Char('[') + damageTypeName(*term.type) + QLatin1Char(']');
+        if (roll.probability() < 1.0)
+            result += QLatin1Char('@') + QString::number(qRound(roll.probability() * 100))
+                    + QLatin1Char('%');
+    }
+    return result;
+}
+
+double DamageExpression::average(const Resistances& resistances) const
+{
+    double result = 0.0;
+    for (const Term& term : m_terms) {
+        const double resistance = term.type ? resistances.value(*term.type, 0.0) : 0.0;
+        result += term.roll.resistance(resistance).average();
+    }
+    return result;
+}
+
+Distribution DamageExpression::distribution(const Resistances& resistances) const
+{
+    return compile(m_terms, resistances).evaluate();
+}
+
+int DamageExpression::graphSize(const Resistances& resistances) const
+{
+    return compile(m_terms, resistances).nodes().size();
+}
+
+QString Calculators::damageTypeName(DamageType type)
+{
+    for (const auto& entry : typeNames) {
+        if (entry.type == type)
+            return QLatin1String(entry.name);
+    }
+    Q_UNREACHABLE();
+    return QString();
+}
+
+bool Calculators::operator==(const DamageExpression::Term& a, const DamageExpression::Term& b)
+{
+    return a.roll == b.roll && a.type == b.type
+        // qFuzzyCompare can't deal well with 0.0. Shifting both is fine.
+        && qFuzzyCompare(a.roll.probability() + 1.0, b.roll.probability() + 1.0);
+}
@@ -0,0 +1,85 @@
+/*
+ * This file is part of Moebius Toolkit.
+ * Copyright (C) 2026 Alejandro Exojo Piqueras
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QString>
+#include <QVector>
+
+#include "calculators.h"
+#include "diceroll.h"
+#include "distribution.h"
+
+#include <optional>
+
+namespace Calculators
+{
+
+/*!
+ * \brief Sum of damage rolls, each of some type and with a chance to happen
+ *
+ * It's written like "1d8+3 + 1d6[fire] + 2d4[acid]@25%": terms separated by
+ * "+", each one dice (with the bonus right after, without spaces) or a plain
+ * number, then optionally the damage type in brackets, and the probability of
+ * happening after "@". A sign followed by dice starts another term, so
+ * "1d8+1d6" is two terms. Terms without a type are never resisted.
+ *
+ * distribution() compiles the terms to a graph of the rolls, the mixtures for
+ * the probabilities and the sums, where identical nodes appear only once (so a
+ * weapon with 1d6 fire and 1d6 cold calculates the 1d6 once, and two identical
+ * terms are one power instead of two sums), and evaluates it in one pass.
+ */
+class DamageExpression
+{
+public:
+    struct Term
+    {
+        DiceRoll roll;
+        std::optional<DamageType> type;
+    };
+    using Resistances = DamageMap<double>;
+
+    explicit DamageExpression() = default;
+    explicit DamageExpression(const QVector<Term>& terms);
+
+    /// Parses \a text. If it has errors, \a ok is set to false (if not null),
+    /// and the result is empty.
+    static DamageExpression fromString(const QString& text, bool* ok = nullptr);
+    /// The on hit damage of the arrangement, with the bonuses to the physical roll.
+    static DamageExpression fromArrangement(const WeaponArrangement& arrangement);
+    /// The text that fromString() reads, which has only the dice, bonus, type
+    /// and probability of each term. The luck and resistance of the rolls
+    /// (e.g. from fromArrangement()) have no syntax, so they are not written.
+    QString toString() const;
+
+    [[nodiscard]] inline const QVector<Term>& terms() const {return m_terms;}
+
+    double average(const Resistances& resistances = {}) const;
+    Distribution distribution(const Resistances& resistances = {}) const;
+    /// Number of different nodes that distribution() has to evaluate.
+    int graphSize(const Resistances& resistances = {}) const;
+
+private:
+    QVector<Term> m_terms;
+};
+
+QString damageTypeName(DamageType type);
+
+bool operator==(const DamageExpression::Term& a, const DamageExpression::Term& b);
+
+}
@@ -0,0 +1,190 @@
+/*
+ * This file is part of Moebius Toolkit.
+ * Copyright (C) 2026 Alejandro Exojo Piqueras
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "damagegraph.h"
+
+#include <bit>
+
+using namespace Calculators;
+
+namespace
+{
+
+template <typename T>
+bool same(const T& a, const T& b)
+{
+    return a == b;
+}
+
+// The operator== of DiceRoll doesn't look at the probability, but the average
+// depends on it.
+bool same(const DiceRoll& a, const DiceRoll& b)
+{
+    return a == b && a.probability() == b.probability();
+}
+
+bool same(const std::optional<DiceRoll>& a, const std::optional<DiceRoll>& b)
+{
+    return a && b ? same(*a, *b) : a.has_value() == b.has_value();
+}
+
+}
+
+template <typename T>
+void DamageGraph::set(Node<T>& input, const T& value)
+{
+    if (input.version != 0 && same(input.value, value))
+        return;
+    input.value = value;
+    input.version = ++m_clock;
+}
+
+template <typename T, typename Function>
+void DamageGraph::update(Node<T>& node, const QVector<int>& inputs, Function compute)
+{
+    if (node.version != 0 && node.inputs == inputs)
+        return;
+    node.inputs = inputs;
+    ++m_recomputed;
+    T value = compute();
+    if (node.version != 0 && node.value == value)
+        return;
+    node.value = std::move(value);
+    node.version = ++m_clock;
+}
+
+void DamageGraph::setArrangement(Damage::Hand hand, const WeaponArrangement& arrangement)
+{
+    Hand& nodes = m_hands[hand];
+    // A weapon without damage is not a weapon. See physicalDamageType().
+    set(nodes.physicalRoll, arrangement.physicalDamage());
+    set(nodes.physicalTypes,
+        std::popcount(uint(arrangement.damage.mask() & DamageMap<DiceRoll>::PhysicalMask)));
+    for (int index = 0; index < Elementals; ++index) {
+        const DamageType type = DamageMap<DiceRoll>::typeAt(index + 4);
+        std::optional<DiceRoll> roll;
+        if (arrangement.damage.contains(type))
+            roll = arrangement.damage.value(type);
+        set(nodes.elementalRolls[index], roll);
+    }
+    set(nodes.toHit, arrangement.toHitBonuses());
+    set(nodes.criticalHit, arrangement.criticalHit);
+    set(nodes.criticalMiss, arrangement.criticalMiss);
+    set(nodes.attacks, arrangement.attacks);
+}
+
+void DamageGraph::setCommon(const Damage::Common& common)
+{
+    set(m_thac0, common.thac0 - common.toHitBonuses());
+    set(m_damageBonus, common.damageBonuses());
+}
+
+void DamageGraph::setSweep(const Damage::Sweep& sweep)
+{
+    set(m_range, qMakePair(sweep.acFrom, sweep.acTo));
+    set(m_hands[Damage::One].acModifier, sweep.acModifier1);
+    set(m_hands[Damage::Two].acModifier, sweep.acModifier2);
+    set(m_offHand, sweep.offHand);
+    set(m_doubleCriticalDamage, sweep.doubleCriticalDamage);
+    set(m_criticalStrike, sweep.criticalStrike);
+    set(m_maximumDamage, sweep.maximumDamage);
+}
+
+void DamageGraph::evaluate(Hand& hand)
+{
+    update(hand.thac0, {m_thac0.version, hand.toHit.version}, [&] {
+        return m_thac0.value - hand.toHit.value;
+    });
+
+    update(hand.physical,
+           {hand.physicalRoll.version, hand.physicalTypes.version,
+            m_damageBonus.version, m_maximumDamage.version}, [&] {
+        DiceRoll roll = hand.physicalRoll.value;
+        roll.bonus(roll.bonus() + m_damageBonus.value);
+        if (m_maximumDamage.value) // Kai or Righteous Magic: +20 luck.
+            roll.luck(roll.luck() + 20);
+        return hand.physicalTypes.value * roll.average();
+    });
+
+    // Elemental damage doesn't get bonuses, nor maximum damage.
+    QVector<int> elementals = {hand.physical.version};
+    for (int index = 0; index < Elementals; ++index) {
+        const auto& roll = hand.elementalRolls[index];
+        update(hand.elementals[index], {roll.version}, [&] {
+            return roll.value ? roll.value->average() : 0.0;
+        });
+        elementals.append(hand.elementals[index].version);
+    }
+    update(hand.regular, elementals, [&] {
+        double result = hand.physical.value;
+        for (const Node<double>& elemental : hand.elementals)
+            result += elemental.value;
+        return result;
+    });
+
+    update(hand.critical,
+           {hand.regular.version, hand.physical.version, m_doubleCriticalDamage.version}, [&] {
+        return hand.regular.value + (m_doubleCriticalDamage.value ? hand.physical.value : 0.0);
+    });
+
+    update(hand.averageAttacks, {hand.attacks.version}, [&] {
+        return RoundSchedule::of(hand.attacks.value).average();
+    });
+
+    update(hand.hitTable,
+           {hand.thac0.version, hand.criticalHit.version, hand.criticalMiss.version,
+            m_criticalStrike.version, m_range.version, hand.acModifier.version}, [&] {
+        // Critical Strike makes every roll a critical hit.
+        const int criticalHit = m_criticalStrike.value ? 100 : hand.criticalHit.value;
+        const int modifier = hand.acModifier.value;
+        return Damage::hitTable(hand.thac0.value, criticalHit, hand.criticalMiss.value,
+                                m_range.value.first - modifier, m_range.value.second - modifier);
+    });
+}
+
+const QVector<double>& DamageGraph::averageDamages()
+{
+    m_recomputed = 0;
+
+    const bool offHand = m_offHand.value;
+    QVector<int> inputs = {m_offHand.version};
+    for (int index = 0, hands = offHand ? 2 : 1; index < hands; ++index) {
+        Hand& hand = m_hands[index];
+        evaluate(hand);
+        inputs << hand.regular.version << hand.critical.version
+               << hand.averageAttacks.version << hand.hitTable.version;
+    }
+
+    update(m_damages, inputs, [&] {
+        const int size = m_hands[Damage::One].hitTable.value.size();
+        QVector<double> result(size, 0.0);
+        for (int index = 0, hands = offHand ? 2 : 1; index < hands; ++index) {
+            const Hand& hand = m_hands[index];
+            // Damage per roll of the die to hit, so only the count of rolls is left.
+            const double regular = hand.averageAttacks.value * hand.regular.value / 20;
+            const double critical = hand.averageAttacks.value * hand.critical.value / 20;
+            for (int ac = 0; ac < size; ++ac) {
+                const auto [hits, criticals] = hand.hitTable.value.at(ac);
+                result[ac] += hits * regular + criticals * critical;
+            }
+        }
+        return result;
+    });
+    return m_damages.value;
+}
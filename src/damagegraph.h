@@ -0,0 +1,117 @@
+/*
+ * This file is part of Moebius Toolkit.
+ * Copyright (C) 2026 Alejandro Exojo Piqueras
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#pragma once
+
+#include <QPair>
+#include <QVector>
+
+#include "calculators.h"
+
+#include <array>
+#include <optional>
+
+/*!
+ * \brief The average damage per round of each armor class, as a dataflow graph
+ *
+ * The same result as Damage::averageDamages(), but split in nodes (the THAC0
+ * of each hand, the average of each type of damage, the table of hits, etc.)
+ * that keep their value between calls. Each node remembers the versions of the
+ * inputs it was computed from, and gets computed again only when one of them
+ * changed. A node whose new value is the same as before keeps its version, so
+ * the nodes that depend on it are not recomputed either (e.g. changing the
+ * dice of a weapon doesn't touch the tables of hits, and a different weapon
+ * with the same bonus to hit doesn't either).
+ *
+ * The off hand is not evaluated at all while it's disabled. All the inputs
+ * need to be set before the first call to averageDamages().
+ */
+class DamageGraph
+{
+public:
+    /// The computed nodes (the inputs are not counted), which is how many
+    /// get recomputed the first time, or when everything changed.
+    static constexpr int NodeCount = 25;
+
+    explicit DamageGraph() = default;
+
+    void setArrangement(Calculators::Damage::Hand hand,
+                        const Calculators::WeaponArrangement& arrangement);
+    void setCommon(const Calculators::Damage::Common& common);
+    void setSweep(const Calculators::Damage::Sweep& sweep);
+
+    /// Recomputes what depends on the inputs changed since the last call, and
+    /// returns the damage against each armor class of the sweep.
+    const QVector<double>& averageDamages();
+    /// How many nodes the last call to averageDamages() had to compute again.
+    int recomputedNodes() const { return m_recomputed; }
+
+private:
+    template <typename T>
+    struct Node
+    {
+        T value = T();
+        int version = 0; // Changes only with the value. 0 until it has one.
+        QVector<int> inputs; // The versions of the inputs of the last value.
+    };
+
+    static constexpr int Elementals = Calculators::DamageMap<double>::Size - 4;
+
+    struct Hand
+    {
+        // Inputs.
+        Node<DiceRoll> physicalRoll;
+        Node<int> physicalTypes; // Each present one does the physical damage.
+        std::array<Node<std::optional<DiceRoll>>, Elementals> elementalRolls;
+        Node<int> toHit;
+        Node<int> criticalHit;
+        Node<int> criticalMiss;
+        Node<double> attacks;
+        Node<int> acModifier;
+
+        // Computed.
+        Node<int> thac0;
+        Node<double> physical;
+        std::array<Node<double>, Elementals> elementals;
+        Node<double> regular;
+        Node<double> critical;
+        Node<double> averageAttacks;
+        Node<QVector<QPair<int, int>>> hitTable;
+    };
+
+    template <typename T>
+    void set(Node<T>& input, const T& value);
+    template <typename T, typename Function>
+    void update(Node<T>& node, const QVector<int>& inputs, Function compute);
+    void evaluate(Hand& hand);
+
+    std::array<Hand, 2> m_hands;
+    Node<int> m_thac0; // Already with the bonuses to hit.
+    Node<int> m_damageBonus;
+    Node<QPair<int, int>> m_range;
+    Node<bool> m_offHand;
+    Node<bool> m_doubleCriticalDamage;
+    Node<bool> m_criticalStrike;
+    Node<bool> m_maximumDamage;
+
+    Node<QVector<double>> m_damages;
+
+    int m_clock = 0;
+    int m_recomputed = 0;
+};
@@ -0,0 +1,176 @@
+/*
+ * This file is part of Moebius Toolkit.
+ * Copyright (C) 2026 Alejandro Exojo Piqueras
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "damagesweep.h"
+
+#include <QThread>
+
+#include <limits>
+
+#ifndef Q_OS_WASM
+#include <QAtomicInt>
+#include <QThreadPool>
+#endif
+
+using namespace DamageSweep;
+using namespace Calculators;
+
+namespace
+{
+    // An empty list is the base value, which counts as one.
+    template <typename T>
+    int dimension(const QVector<T>& values)
+    {
+        return qMax(1, int(values.size()));
+    }
+
+    template <typename T>
+    T valueAt(const QVector<T>& values, int index, T base)
+    {
+        return values.isEmpty() ? base : values.at(index);
+    }
+}
+
+Bonus DamageSweep::strengthBonus(int strength)
+{
+    Q_ASSERT(strength >= 1 && strength <= 25);
+    static constexpr Bonus table[] = {
+        {-5, -4}, {-3, -2}, {-3, -1}, {-2, -1}, {-2, -1}, // 1-5
+        {-1, 0}, {-1, 0}, {0, 0}, {0, 0}, {0, 0},         // 6-10
+        {0, 0}, {0, 0}, {0, 0}, {0, 0}, {0, 0},           // 11-15
+        {0, 1}, {1, 1}, {1, 2}, {3, 7}, {3, 8},           // 16-20
+        {4, 9}, {4, 10}, {5, 11}, {6, 12}, {7, 14},       // 21-25
+    };
+    return table[qBound(1, strength, 25) - 1];
+}
+
+Bonus DamageSweep::proficiencyBonus(int points)
+{
+    Q_ASSERT(points >= 0 && points <= 5);
+    static constexpr Bonus table[] = {
+        {-2, 0}, // Unskilled
+        {0, 0},  // Proficient
+        {1, 2},  // Specialized
+        {3, 3},  // Master
+        {3, 4},  // High master
+        {3, 5},  // Grand master
+    };
+    return table[qBound(0, points, 5)];
+}
+
+qint64 Grid::size() const
+{
+    return qint64(dimension(thac0)) * dimension(strength) * dimension(proficiency)
+            * dimension(attacks) * armorClasses();
+}
+
+Point Results::point(qint64 row) const
+{
+    Q_ASSERT(row >= 0 && row < grid.size());
+    Point result;
+    const int step = grid.acFrom <= grid.acTo ? 1 : -1;
+    result.ac = grid.acFrom + step * int(row % grid.armorClasses());
+    row /= grid.armorClasses();
+    result.attacks = valueAt(grid.attacks, int(row % dimension(grid.attacks)),
+                             grid.weapon.attacks);
+    row /= dimension(grid.attacks);
+    result.proficiency = valueAt(grid.proficiency, int(row % dimension(grid.proficiency)), -1);
+    row /= dimension(grid.proficiency);
+    result.strength = valueAt(grid.strength, int(row % dimension(grid.strength)), -1);
+    row /= dimension(grid.strength);
+    result.thac0 = valueAt(grid.thac0, int(row), grid.common.thac0);
+    return result;
+}
+
+Results DamageSweep::evaluate(const Grid& grid, const Options& options)
+{
+    Results results;
+    results.grid = grid;
+    const qint64 size = grid.size();
+    Q_ASSERT(size <= std::numeric_limits<int>::max());
+    results.damage.resize(int(size));
+    results.hitChance.resize(int(size));
+
+    const int proficiencies = dimension(grid.proficiency);
+    const int strengths = dimension(grid.strength);
+    const int blocks = dimension(grid.thac0) * strengths * proficiencies;
+    const int rowsPerBlock = dimension(grid.attacks) * grid.armorClasses();
+
+    auto runBlock = [&](int block) {
+        const int proficiency = block % proficiencies;
+        const int strength = block / proficiencies % strengths;
+        const int thac0 = block / proficiencies / strengths;
+
+        Damage::Common common = grid.common;
+        common.thac0 = valueAt(grid.thac0, thac0, common.thac0);
+        if (!grid.strength.isEmpty()) {
+            const Bonus bonus = strengthBonus(grid.strength.at(strength));
+            common.statToHit = bonus.toHit;
+            common.statDamage = bonus.damage;
+        }
+        WeaponArrangement weapon = grid.weapon;
+        if (!grid.proficiency.isEmpty()) {
+            const Bonus bonus = proficiencyBonus(grid.proficiency.at(proficiency));
+            weapon.proficiencyToHit = bonus.toHit;
+            weapon.proficiencyDamage = bonus.damage;
+        }
+
+        const Damage damage(weapon, weapon, common);
+        const double regular = damage.onHitDamage(Damage::One, Damage::Regular);
+        const double critical = damage.onHitDamage(Damage::One, grid.critical);
+        const auto hits = damage.hitTable(Damage::One, grid.acFrom, grid.acTo);
+
+        float* damageRow = results.damage.data() + qint64(block) * rowsPerBlock;
+        float* hitChanceRow = results.hitChance.data() + qint64(block) * rowsPerBlock;
+        for (int attack = 0, count = dimension(grid.attacks); attack < count; ++attack) {
+            const double attacks = valueAt(grid.attacks, attack, weapon.attacks);
+            for (const auto& [regulars, criticals] : hits) {
+                *damageRow++ = float(attacks * (regulars * regular + criticals * critical) / 20);
+                *hitChanceRow++ = float((regulars + criticals) / 20.0);
+            }
+        }
+    };
+
+#ifndef Q_OS_WASM
+    const int threads = qMin(options.threads > 0 ? options.threads : QThread::idealThreadCount(),
+                             blocks);
+    if (threads > 1) {
+        QAtomicInt next = 0;
+        QThreadPool pool;
+        pool.setMaxThreadCount(threads);
+        for (int thread = 0; thread < threads; ++thread) {
+            pool.start([&] {
+                for (int block = next.fetchAndAddRelaxed(1); block < blocks;
+                     block = next.fetchAndAddRelaxed(1))
+                {
+                    runBlock(block);
+                }
+            });
+        }
+        pool.waitForDone();
+    }
+    else
+#else
+    Q_UNUSED(options)
+#endif
+    {
+        for (int block = 0; block < blocks; ++block)
+            runBlock(block);
+    }
+    return results;
+}
@@ -0,0 +1,115 @@
+/*
+ * This file is part of Moebius Toolkit.
+ * Copyright (C) 2026 Alejandro Exojo Piqueras
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QVector>
+
+#include "calculators.h"
+
+/*!
+ * The damage per round of a weapon for every point of a grid of parameters,
+ * e.g. THAC0 20 to 0, Strength 16 to 25, all the proficiency levels, 1 to 5
+ * attacks per round, against AC -5 to 5.
+ *
+ * Only the THAC0, Strength and proficiency change the damage on hit and the
+ * hit chances, so each of their combinations is one block of work, which
+ * calculates those once (with Damage::hitTable() for the whole range of AC)
+ * and then fills the rows of all the attacks and armor classes. The threads
+ * take the blocks from a shared counter, so the ones that finish early just
+ * take more, and each block writes to its own rows of the results, which are
+ * allocated up front. So the results are the same with any number of threads.
+ */
+namespace DamageSweep
+{
+
+struct Bonus
+{
+    int toHit = 0;
+    int damage = 0;
+};
+
+/// The default bonuses of a Strength score (without the exceptional 18/xx).
+Bonus strengthBonus(int strength);
+/// The bonuses of the proficiency points of a warrior (0 is unskilled).
+Bonus proficiencyBonus(int points);
+
+/*!
+ * \brief The parameters to sweep, and the values that stay the same
+ *
+ * An empty list of values means that the one from the weapon or common is
+ * used, which counts as one value in the grid.
+ */
+struct Grid
+{
+    Calculators::WeaponArrangement weapon;
+    Calculators::Damage::Common common;
+    /// What a critical hit does to the damage (helmets prevent the doubling).
+    Calculators::Damage::Stat critical = Calculators::Damage::Critical;
+
+    QVector<int> thac0;
+    QVector<int> strength;
+    QVector<int> proficiency;
+    QVector<double> attacks;
+    /// From \a acFrom to \a acTo, both included, in that order.
+    int acFrom = 0;
+    int acTo = 0;
+
+    int armorClasses() const { return qAbs(acTo - acFrom) + 1; }
+    /// The number of points, which is the product of the size of each list.
+    qint64 size() const;
+};
+
+/// The values of the parameters of a row of the results. The Strength and
+/// proficiency are -1 if they are not swept (so the bonuses are the base ones).
+struct Point
+{
+    int thac0 = 0;
+    int strength = 0;
+    int proficiency = 0;
+    double attacks = 0.0;
+    int ac = 0;
+};
+
+/*!
+ * \brief One column per result, and one row per point of the grid
+ *
+ * The rows go in the order of the grid with the AC changing the fastest, then
+ * the attacks, proficiency, Strength and THAC0, so the parameters of a row are
+ * implicit (see point()), and don't take memory.
+ */
+struct Results
+{
+    Grid grid;
+    /// Average damage per round.
+    QVector<float> damage;
+    /// Probability of hitting (regular or critical) with each attack.
+    QVector<float> hitChance;
+
+    Point point(qint64 row) const;
+};
+
+struct Options
+{
+    /// 0 uses as many threads as cores.
+    int threads = 0;
+};
+
+Results evaluate(const Grid& grid, const Options& options = {});
+
+}
@@ -0,0 +1,121 @@
+/*
+ * This file is part of Moebius Toolkit.
+ * Copyright (C) 2026 Alejandro Exojo Piqueras
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QVector>
+
+// Rolls with many dice overflow 64 bits quickly (25d6 already does), so use
+// 128 bits as the next step when the compiler has them (not MSVC).
+#if defined(__SIZEOF_INT128__)
+#define MOEBIUS_HAVE_INT128
+using WideCount = unsigned __int128;
+#endif
+
+/*!
+ * \brief Exact number of outcomes of a roll that give each value
+ *
+ * The entry at index 0 of counts is the number of outcomes that give first,
+ * the next one of first+1, and so on. They add up to total, which is the
+ * number of outcomes (sides^number). Working with counts is exact, unlike with
+ * probabilities, which only become doubles at the very end, if needed. Count is
+ * an unsigned integer type (quint64, or WideCount if available).
+ */
+template <typename Count>
+struct DiceCounts
+{
+    int first = 0;
+    QVector<Count> counts = {1};
+    Count total = 1;
+
+    [[nodiscard]] inline int last() const {return first + counts.size() - 1;}
+
+    Count count(int value) const
+    {
+        const int index = value - first;
+        return index >= 0 && index < counts.size() ? counts.at(index) : Count(0);
+    }
+};
+
+namespace DiceCountsDetail
+{
+
+// Portable versions of __builtin_add_overflow and __builtin_mul_overflow, which
+// MSVC doesn't have. They return false if the result doesn't fit.
+template <typename Count>
+inline bool add(Count a, Count b, Count& result)
+{
+    result = a + b;
+    return result >= a;
+}
+
+template <typename Count>
+inline bool multiply(Count a, Count b, Count& result)
+{
+    if (a != 0 && b > Count(~Count(0)) / a)
+        return false;
+    result = a * b;
+    return true;
+}
+
+}
+
+/*!
+ * Counts the outcomes of rolling \a number dice of \a sides with \a luck,
+ * adding one dice at a time. Returns false, leaving \a result untouched, if
+ * some count doesn't fit in the Count type.
+ */
+template <typename Count>
+bool countOutcomes(int number, int sides, int luck, DiceCounts<Count>& result)
+{
+    using namespace DiceCountsDetail;
+    Q_ASSERT(number >= 0 && sides >= 1);
+
+    // How many faces of one dice give each value after luck (e.g. with +2 luck
+    // on a d6, the 1 can't happen, and the 6 happens with 3 faces).
+    const int low = qBound(1, 1 + luck, sides);
+    QVector<Count> oneDice(sides, Count(0));
+    for (int face = 1; face <= sides; ++face)
+        ++oneDice[qBound(1, face + luck, sides) - 1];
+    int oneDiceSize = sides;
+    while (oneDice.at(oneDiceSize - 1) == 0)
+        --oneDiceSize;
+    oneDice = oneDice.mid(low - 1, oneDiceSize - low + 1);
+
+    DiceCounts<Count> counts;
+    for (int dice = 0; dice < number; ++dice) {
+        QVector<Count> next(counts.counts.size() + oneDice.size() - 1, Count(0));
+        for (int i = 0, iSize = counts.counts.size(); i < iSize; ++i) {
+            for (int j = 0, jSize = oneDice.size(); j < jSize; ++j) {
+                Count product;
+                if (!multiply(counts.counts.at(i), oneDice.at(j), product)
+                        || !add(next.at(i + j), product, next[i + j]))
+                {
+                    return false;
+                }
+            }
+        }
+        counts.counts = next;
+        counts.first += low;
+        if (!multiply(counts.total, Count(sides), counts.total))
+            return false;
+    }
+
+    result = counts;
+    return true;
+}
@@ -18,26 +18,166 @@
 
 #include "diceroll.h"
 
+#include "dicetables.h"
+#include "fixeddice.h"
+
+#include <QCache>
 #include <QDebug>
+#include <QMutex>
 #include <QtMath>
 
+#include <cstring>
+#include <optional>
+
 namespace
 {
-// This function is CC-BY-SA 3.0: https://stackoverflow.com/a/17050528/9164547
-    QVector<QVector<int>> cartesianProduct(const QVector<QVector<int>>& inputs)
+    // Everything that can change the result of a roll. The doubles are stored
+    // as their bits: the cache wants the same input, not a similar one.
+    struct CacheKey
+    {
+        explicit CacheKey(const DiceRoll& roll)
+            : number(roll.number())
+            , sides(roll.sides())
+            , bonus(roll.bonus())
+            , luck(roll.luck())
+        {
+            const double resistanceValue = roll.resistance();
+            const double probabilityValue = roll.probability();
+            std::memcpy(&resistance, &resistanceValue, sizeof(resistance));
+            std::memcpy(&probability, &probabilityValue, sizeof(probability));
+        }
+
+        int number, sides, bonus, luck;
+        quint64 resistance, probability;
+    };
+
+    bool operator==(const CacheKey& a, const CacheKey& b)
     {
-        QVector<QVector<int>> result = {{}};
-        for (const auto& u : inputs) {
-            QVector<QVector<int>> r;
-            for (const auto& x : result) {
-                for (const auto y : u) {
-                    r.append(x);
-                    r.last().append(y);
+        return a.number == b.number && a.sides == b.sides && a.bonus == b.bonus
+            && a.luck == b.luck && a.resistance == b.resistance
+            && a.probability == b.probability;
+    }
+
+    // No padding in the struct, so hashing the bytes is hashing the values.
+    static_assert(sizeof(CacheKey) == 4*sizeof(int) + 2*sizeof(quint64));
+    size_t qHash(const CacheKey& key, size_t seed = 0)
+    {
+        return qHashBits(&key, sizeof(key), seed);
+    }
+
+    // Each statistic gets filled only when asked for. Computing the average
+    // doesn't need the distribution, for example, and would be a waste.
+    struct CacheEntry
+    {
+        std::optional<double> average;
+        std::optional<double> sigma;
+        std::optional<Distribution> distribution;
+        std::optional<CumulativeDistribution> cumulativeDistribution;
+    };
+
+    class StatisticsCache
+    {
+    public:
+        template <typename T, typename Calculate>
+        T value(const DiceRoll& roll, std::optional<T> CacheEntry::* field, Calculate calculate)
+        {
+            const CacheKey key(roll);
+            {
+                QMutexLocker locker(&m_mutex);
+                const CacheEntry* entry = m_entries.object(key);
+                if (entry && (entry->*field)) {
+                    ++m_hits;
+                    return *(entry->*field);
                 }
+                ++m_misses;
+            }
+
+            // Calculated unlocked, so other threads are not waiting meanwhile.
+            // At worst two threads calculate the same, and the last one wins.
+            const T result = calculate();
+
+            QMutexLocker locker(&m_mutex);
+            CacheEntry* entry = m_entries.object(key);
+            if (!entry) {
+                entry = new CacheEntry;
+                // QCache deletes the entry right away if it doesn't fit.
+                if (!m_entries.insert(key, entry))
+                    return result;
             }
-            result = std::move(r);
+            entry->*field = result;
+            return result;
         }
-        return result;
+
+        DiceRoll::CacheStatistics statistics()
+        {
+            QMutexLocker locker(&m_mutex);
+            DiceRoll::CacheStatistics result;
+            result.hits = m_hits;
+            result.misses = m_misses;
+            result.size = m_entries.size();
+            result.capacity = m_entries.maxCost();
+            return result;
+        }
+
+        void setCapacity(int entries)
+        {
+            QMutexLocker locker(&m_mutex);
+            m_entries.setMaxCost(entries);
+        }
+
+        void clear()
+        {
+            QMutexLocker locker(&m_mutex);
+            m_entries.clear();
+            m_hits = 0;
+            m_misses = 0;
+        }
+
+    private:
+        QMutex m_mutex;
+        // Each entry costs 1, so the capacity is the number of different rolls.
+        QCache<CacheKey, CacheEntry> m_entries{4096};
+        qint64 m_hits = 0;
+        qint64 m_misses = 0;
+    };
+
+    Q_GLOBAL_STATIC(StatisticsCache, statisticsCache)
+
+    // The counts of the dice, with bonus and resistance applied like in
+    // DiceRoll::calculateDistribution(). The sum of merged counts can't be more
+    // than the total, so it can't overflow.
+    template <typename Count>
+    bool exactCounts(const DiceRoll& roll, DiceCounts<Count>& result)
+    {
+        DiceCounts<Count> dice;
+        if (!countOutcomes(roll.number(), roll.sides(), roll.luck(), dice))
+            return false;
+
+        const QVector<int> resisted = roll.resistanceTable();
+        const int first = resisted.first();
+        result.first = first;
+        result.total = dice.total;
+        result.counts = QVector<Count>(resisted.last() - first + 1, Count(0));
+        for (int index = 0, size = dice.counts.size(); index < size; ++index)
+            result.counts[resisted.at(index) - first] += dice.counts.at(index);
+        return true;
+    }
+
+    template <typename Count>
+    Distribution distributionFromCounts(const DiceCounts<Count>& counts, double probability)
+    {
+        QVector<double> probabilities(counts.counts.size());
+        for (int index = 0, size = counts.counts.size(); index < size; ++index)
+            probabilities[index] = double(counts.counts.at(index)) / double(counts.total);
+        return Distribution(counts.first, probabilities).mixed(probability);
+    }
+
+    // See the comment on DiceRoll::calculateSigma().
+    double sigmaFromMoments(double rollMean, double rollVariance, double mu, double probability)
+    {
+        const double result = probability * (rollVariance + qPow(rollMean - mu, 2))
+                            + (1.0 - probability) * qPow(mu, 2);
+        return qSqrt(qMax(0.0, result));
     }
 }
 
@@ -51,21 +191,21 @@ DiceRoll::DiceRoll(const Arguments& arguments)
 {
 }
 
-// TODO: simplify the cartesian product function with something that can assume
-// our case: each dice is equal, so {1,2,3}{1,2,3} is redundant. We could pass
-// something like {1,2,3}{2} as input instead, and ditch the "more advanced"
-// cartesian product if needed.
+// Kept for tests and debugging, as it's convenient to compare against a list.
+// Anything that needs to visit each outcome should iterate outcomes() instead.
 DiceRoll::Permutations DiceRoll::permutations() const
 {
-    QVector<QVector<int>> inputs;
-
-    QVector<int> oneDiceRolls;
-    for (int x = 1; x <= m_sides; ++x)
-        oneDiceRolls.append(luckified(x));
-    for (int x = 1; x <= m_number; ++x)
-        inputs.append(oneDiceRolls);
+    const Outcomes outcomes = this->outcomes();
+    Permutations result;
+    result.reserve(outcomes.size());
+    for (const QVector<int>& rolls : outcomes)
+        result.append(rolls);
+    return result;
+}
 
-    return cartesianProduct(inputs);
+DiceRoll::Outcomes DiceRoll::outcomes() const
+{
+    return Outcomes(*this);
 }
 
 DiceRoll& DiceRoll::sides(int sides)
@@ -148,11 +288,109 @@ int DiceRoll::minimum() const
     return m_number * qBound(1, 1+m_luck, m_sides) + m_bonus;
 }
 
+// The common weapon dice have a specialization without loops, which is
+// cheaper than even looking up the cache.
 double DiceRoll::average() const
 {
     double result = 0.0;
-    for (int i = 1; i <= m_sides; ++i)
-        result += resistified(m_number * luckified(i) + m_bonus);
+    if (FixedDiceDispatch::average(m_number, m_sides, m_bonus, m_luck, m_resistance,
+                                   m_probability, result))
+    {
+        return result;
+    }
+    return statisticsCache->value(*this, &CacheEntry::average,
+                                  [this] { return calculateAverage(); });
+}
+
+double DiceRoll::sigma() const
+{
+    if (qFuzzyIsNull(m_resistance)) {
+        if (const DiceTables::Table* table = DiceTables::find(m_number, m_sides, m_luck))
+            return sigmaFromMoments(table->mean() + m_bonus, table->variance(),
+                                    average(), m_probability);
+    }
+    return statisticsCache->value(*this, &CacheEntry::sigma,
+                                  [this] { return calculateSigma(); });
+}
+
+Distribution DiceRoll::distribution() const
+{
+    return statisticsCache->value(*this, &CacheEntry::distribution,
+                                  [this] { return calculateDistribution(); });
+}
+
+CumulativeDistribution DiceRoll::cumulativeDistribution() const
+{
+    return statisticsCache->value(*this, &CacheEntry::cumulativeDistribution,
+                                  [this] { return CumulativeDistribution(distribution()); });
+}
+
+double DiceRoll::probabilityAtLeast(int value) const
+{
+    return cumulativeDistribution().probabilityAtLeast(value);
+}
+
+int DiceRoll::quantile(double probability) const
+{
+    return cumulativeDistribution().quantile(probability);
+}
+
+DiceCounts<quint64> DiceRoll::counts(bool* ok) const
+{
+    DiceCounts<quint64> result;
+    const bool fits = exactCounts(*this, result);
+    if (ok)
+        *ok = fits;
+    return fits ? result : DiceCounts<quint64>{0, {}, 0};
+}
+
+Distribution DiceRoll::exactDistribution(bool* exact) const
+{
+    if (exact)
+        *exact = true;
+
+    DiceCounts<quint64> counts;
+    if (exactCounts(*this, counts))
+        return distributionFromCounts(counts, m_probability);
+#ifdef MOEBIUS_HAVE_INT128
+    DiceCounts<WideCount> wideCounts;
+    if (exactCounts(*this, wideCounts))
+        return distributionFromCounts(wideCounts, m_probability);
+#endif
+
+    if (exact)
+        *exact = false;
+    return distribution();
+}
+
+DiceRoll::CacheStatistics DiceRoll::cacheStatistics()
+{
+    return statisticsCache->statistics();
+}
+
+void DiceRoll::setCacheCapacity(int entries)
+{
+    statisticsCache->setCapacity(entries);
+}
+
+void DiceRoll::clearCache()
+{
+    statisticsCache->clear();
+}
+
+double DiceRoll::calculateAverage() const
+{
+    const QVector<int> faces = luckTable();
+    double result = 0.0;
+    if (m_resistance == 0.0) {
+        for (int face : faces)
+            result += m_number * face + m_bonus;
+    } else {
+        const QVector<int> resisted = resistanceTable();
+        const int minimum = this->minimum();
+        for (int face : faces)
+            result += resisted.at(m_number * face + m_bonus - minimum);
+    }
     result /= m_sides;
     result *= m_probability;
     return result;
@@ -167,34 +405,77 @@ double DiceRoll::average() const
 // probability of an effect happening), we have to use the one that has the
 // Probability Mass Function (PMF):
 //     \sum_{i=1}^n p_i\cdot(x_i - \mu)^2
-// We can simplify it a bit to our use case: the probability of each entry in
-// the permutations is the same, and the probability of 0 (equivalent to the
-// effect not happening anything) is (1-m_probability). The contribution of each
-// value is (p_i * (x_i - mu)^2), so for 0 is ((1-probability)*mu^2).
-double DiceRoll::sigma() const
+// The PMF is what distribution() returns, with the probability of 0 (the effect
+// not happening) already merged in it, so there is no special case for it.
+//
+// But most of the time there is no resistance involved, and then we don't even
+// need the PMF. The dice are independent, so the variance of the sum is the sum
+// of the variances, and we only need the moments of one luckified dice. Then
+// the effect happens with probability p, or it's 0 otherwise:
+//     p\cdot(\sigma_S^2 + (\mu_S - \mu)^2) + (1-p)\cdot\mu^2
+// Resistance rounds the total (not each dice), so it needs the whole PMF.
+double DiceRoll::calculateSigma() const
 {
     const auto mu = average();
-    const auto permutations = this->permutations();
-    // Probability of each different XdY roll is the same.
-    const auto p = (m_probability / permutations.size());
 
-    double result = 0.0;
-    for (const QVector<int>& rolls : permutations) {
-        double value = 0.0;
-        for (const auto& roll : rolls) {
-            value += roll;
+    if (qFuzzyIsNull(m_resistance)) {
+        double sum = 0.0;
+        double squares = 0.0;
+        for (int x = 1; x <= m_sides; ++x) {
+            const int value = luckified(x);
+            sum += value;
+            squares += value * value;
         }
-        // The bonus doesn't get added to the values from the permutations, as
-        // it should be added only once, here. Then lowered by resistance.
-        value = resistified(value + m_bonus);
-        value = qPow(value - mu, 2);
-        result += p * value;
+        const double oneDiceMean = sum / m_sides;
+        const double oneDiceVariance = squares / m_sides - oneDiceMean * oneDiceMean;
+        return sigmaFromMoments(m_number * oneDiceMean + m_bonus,
+                                m_number * oneDiceVariance, mu, m_probability);
     }
-    // Contribution of 0 happenning.
-    result += (1.0 - m_probability) * qPow(mu, 2);
+
+    const Distribution distribution = this->distribution();
+
+    double result = 0.0;
+    for (int value = distribution.first(); value <= distribution.last(); ++value)
+        result += distribution.probability(value) * qPow(value - mu, 2);
     return qSqrt(result);
 }
 
+// Instead of enumerating every combination of the dice (sides^number of them),
+// start from the PMF of one dice, and convolve it once per dice rolled. Each
+// step is just (values so far) * sides, so a 10d6 is a few hundred operations.
+// The bonus is added only once to the sum, and then lowered by resistance.
+// The common weapon dice don't even need that, as the tables have the sum.
+//
+// Resistance and probability only transform the PMF of the dice, which is the
+// same for every enemy, so that is taken from the cache, and just remapped
+// with a table of the resisted values, instead of doing the dice math again.
+Distribution DiceRoll::calculateDistribution() const
+{
+    if (m_resistance != 0.0 || m_probability != 1.0) {
+        const Distribution dice = DiceRoll(*this).resistance(0.0).probability(1.0).distribution();
+        if (m_resistance == 0.0)
+            return dice.mixed(m_probability);
+        return dice.remapped(resistanceTable()).mixed(m_probability);
+    }
+
+    Distribution result;
+    if (const DiceTables::Table* table = DiceTables::find(m_number, m_sides, m_luck)) {
+        QVector<double> probabilities;
+        for (int value = table->first(), last = table->last(); value <= last; ++value)
+            probabilities.append(double(table->counts[value]) / table->total);
+        result = Distribution(table->first(), probabilities);
+    }
+    else {
+        QVector<double> oneDice(m_sides, 0.0);
+        for (int face : luckTable())
+            oneDice[face - 1] += 1.0 / m_sides;
+        // Big pools (e.g. 20d6 or 40d4) get the sum with an FFT instead.
+        result = Distribution(1, oneDice).power(m_number);
+    }
+
+    return result.shifted(m_bonus);
+}
+
 int DiceRoll::luckified(int value) const
 {
     Q_ASSERT(value >= 1 && value <= m_sides);
@@ -207,6 +488,63 @@ int DiceRoll::resistified(int value) const
     return qCeil(value * (1 - m_resistance));
 }
 
+QVector<int> DiceRoll::luckTable() const
+{
+    QVector<int> result(m_sides);
+    for (int face = 1; face <= m_sides; ++face)
+        result[face - 1] = qBound(1, face + m_luck, m_sides);
+    return result;
+}
+
+QVector<int> DiceRoll::resistanceTable() const
+{
+    const int minimum = this->minimum();
+    QVector<int> result(maximum() - minimum + 1);
+    const double factor = 1 - m_resistance;
+    for (int index = 0, size = result.size(); index < size; ++index)
+        result[index] = qCeil((minimum + index) * factor);
+    return result;
+}
+
+DiceRoll::Outcomes::Outcomes(const DiceRoll& roll)
+    : m_number(roll.number())
+    , m_oneDiceRolls(roll.luckTable())
+{
+}
+
+qint64 DiceRoll::Outcomes::size() const
+{
+    qint64 result = 1;
+    for (int x = 1; x <= m_number; ++x)
+        result *= m_oneDiceRolls.size();
+    return result;
+}
+
+DiceRoll::Outcomes::Iterator::Iterator(const Outcomes& outcomes)
+    : m_oneDiceRolls(&outcomes.m_oneDiceRolls)
+    , m_faces(outcomes.m_number, 0)
+    , m_rolls(outcomes.m_number, outcomes.m_oneDiceRolls.first())
+{
+}
+
+DiceRoll::Outcomes::Iterator& DiceRoll::Outcomes::Iterator::operator++()
+{
+    Q_ASSERT(!m_done);
+    const int sides = m_oneDiceRolls->size();
+    for (int dice = m_faces.size() - 1; dice >= 0; --dice) {
+        int& face = m_faces[dice];
+        if (++face < sides) {
+            m_rolls[dice] = m_oneDiceRolls->at(face);
+            return *this;
+        }
+        face = 0;
+        m_rolls[dice] = m_oneDiceRolls->first();
+    }
+    // All the dice carried over (or there are none): all the outcomes are seen.
+    m_done = true;
+    return *this;
+}
+
 QDebug operator<<(QDebug debug, const DiceRoll& roll)
 {
     QDebugStateSaver saver(debug);
@@ -16,10 +16,16 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <QMetaType>
 #include <QVector>
 
 #pragma once
 
+#include "dicecounts.h"
+#include "distribution.h"
+
+#include <iterator>
+
 class QDebug;
 
 class DiceRoll
@@ -30,11 +36,34 @@ class DiceRoll
     };
 public:
     using Permutations = QVector<QVector<int>>;
+    class Outcomes;
+    struct CacheStatistics {
+        qint64 hits = 0, misses = 0;
+        int size = 0, capacity = 0;
+    };
 
     explicit DiceRoll(const Arguments& arguments);
     explicit DiceRoll() = default;
 
     Permutations permutations() const;
+    /// Same outcomes as permutations(), in the same order, but visited lazily.
+    Outcomes outcomes() const;
+    /// Probability of each possible damage value (after luck, bonus and
+    /// resistance). The probability of the effect not happening is on 0.
+    Distribution distribution() const;
+    CumulativeDistribution cumulativeDistribution() const;
+    /// Exact number of outcomes that give each damage value (after luck, bonus
+    /// and resistance, but not the probability). \a ok is set to false, and
+    /// the result is empty, if there are too many outcomes for 64 bits.
+    DiceCounts<quint64> counts(bool* ok = nullptr) const;
+    /// Same as distribution(), but from the exact counts, divided only at the
+    /// end. If there are too many outcomes even for the widest integers, it's
+    /// distribution(), and \a exact is set to false.
+    Distribution exactDistribution(bool* exact = nullptr) const;
+    /// Probability of doing at least \a value damage (0 if the effect fails).
+    double probabilityAtLeast(int value) const;
+    /// The damage value at the given percentile, e.g. 0.9 for the 90th.
+    int quantile(double probability) const;
 
     [[nodiscard]] inline constexpr int number() const {return m_number;}
     [[nodiscard]] inline constexpr int sides() const {return m_sides;}
@@ -60,14 +89,27 @@ public:
     int maximum() const;
     int minimum() const;
     double average() const;
-    // TODO: Needs unit testing with probability being different from 1. Need to
-    // find a site that allows to calculate the variance with a PMF.
     double sigma() const;
 
     int luckified(int value) const;
     int resistified(int value) const;
+    /// luckified() of each face, from 1 to sides().
+    QVector<int> luckTable() const;
+    /// resistified() of each value, from minimum() to maximum().
+    QVector<int> resistanceTable() const;
+
+    // The results of average(), sigma() and both distributions are kept in a
+    // cache shared by the whole process (and safe to use from any thread), as
+    // the same rolls are asked for again and again while calculating damage.
+    static CacheStatistics cacheStatistics();
+    static void setCacheCapacity(int entries);
+    static void clearCache();
 
 private:
+    double calculateAverage() const;
+    double calculateSigma() const;
+    Distribution calculateDistribution() const;
+
     int m_number = 1;
     int m_sides = 1;
     int m_bonus = 0;
@@ -76,6 +118,56 @@ private:
     double m_probability = 1.0;
 };
 
+/*!
+ * \brief Lazy range over each combination of the dice of a roll
+ *
+ * Iterating it works like an odometer: the last dice moves on each step, and
+ * carries over to the previous one when it has shown all its sides. The rolls
+ * are kept in the same buffer for the whole iteration, so visiting millions of
+ * outcomes doesn't allocate for each of them. The reference returned by the
+ * iterator changes on each increment, so copy it if it has to be kept.
+ */
+class DiceRoll::Outcomes
+{
+public:
+    class Iterator
+    {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = QVector<int>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const QVector<int>*;
+        using reference = const QVector<int>&;
+
+        explicit Iterator(const Outcomes& outcomes);
+
+        reference operator*() const {return m_rolls;}
+        pointer operator->() const {return &m_rolls;}
+        Iterator& operator++();
+        void operator++(int) {++*this;}
+        bool operator==(std::default_sentinel_t) const {return m_done;}
+
+    private:
+        const QVector<int>* m_oneDiceRolls = nullptr;
+        QVector<int> m_faces;
+        QVector<int> m_rolls;
+        bool m_done = false;
+    };
+
+    explicit Outcomes(const DiceRoll& roll);
+
+    Iterator begin() const {return Iterator(*this);}
+    std::default_sentinel_t end() const {return std::default_sentinel;}
+    qint64 size() const;
+
+private:
+    int m_number = 0;
+    // The luckified value of each face of one dice.
+    QVector<int> m_oneDiceRolls;
+};
+
 bool operator==(const DiceRoll& a, const DiceRoll& b);
 
 QDebug operator<<(QDebug debug, const DiceRoll& roll);
+
+Q_DECLARE_METATYPE(DiceRoll)
@@ -0,0 +1,127 @@
+/*
+ * This file is part of Moebius Toolkit.
+ * Copyright (C) 2026 Alejandro Exojo Piqueras
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "dicerollbatch.h"
+
+#include "diceroll.h"
+
+#include <QtMath>
+
+#include <algorithm>
+
+namespace
+{
+    // Sum of the integers from 1 to n, and of their squares.
+    inline double triangular(double n) { return n * (n + 1) / 2; }
+    inline double squarePyramidal(double n) { return n * (n + 1) * (2 * n + 1) / 6; }
+
+    // The moments of one luckified dice, without looping over the sides. Luck
+    // moves every face by the same amount, clamped to [1, sides], so the lowest
+    // value can come from several faces (bad luck) and the highest too (good
+    // luck), and whatever is in between comes from one face each:
+    //     lowFaces*low + (low+1 + ... + high-1) + highFaces*high
+    // If luck is so big that every face ends up the same, that's low == high.
+    struct Moments
+    {
+        double mean;
+        double variance;
+    };
+
+    inline Moments oneDiceMoments(int sides, int luck)
+    {
+        const int low = qBound(1, 1 + luck, sides);
+        const int high = qBound(1, sides + luck, sides);
+        const bool spread = low != high;
+        const double lowFaces = spread ? low - luck : sides;
+        const double highFaces = spread ? sides + luck - high + 1 : 0;
+        const double middleSum = spread ? triangular(high - 1) - triangular(low) : 0;
+        const double middleSquares = spread
+                ? squarePyramidal(high - 1) - squarePyramidal(low) : 0;
+
+        const double sum = lowFaces * low + middleSum + highFaces * high;
+        const double squares = lowFaces * low * low + middleSquares
+                             + highFaces * high * high;
+        const double mean = sum / sides;
+        return {mean, squares / sides - mean * mean};
+    }
+}
+
+void DiceRollBatch::evaluate(const Columns& columns, const Results& results)
+{
+    const std::size_t size = columns.size();
+    Q_ASSERT(columns.sides.size() == size);
+    Q_ASSERT(columns.bonus.size() == size);
+    Q_ASSERT(columns.luck.size() == size);
+    Q_ASSERT(columns.resistance.size() == size);
+    Q_ASSERT(columns.probability.size() == size);
+    Q_ASSERT(results.average.empty() || results.average.size() == size);
+    Q_ASSERT(results.sigma.empty() || results.sigma.size() == size);
+    Q_ASSERT(results.minimum.empty() || results.minimum.size() == size);
+    Q_ASSERT(results.maximum.empty() || results.maximum.size() == size);
+
+    const int* number = columns.number.data();
+    const int* sides = columns.sides.data();
+    const int* bonus = columns.bonus.data();
+    const int* luck = columns.luck.data();
+    const double* probability = columns.probability.data();
+
+    if (!results.minimum.empty()) {
+        int* minimum = results.minimum.data();
+        for (std::size_t row = 0; row < size; ++row)
+            minimum[row] = number[row] * qBound(1, 1 + luck[row], sides[row]) + bonus[row];
+    }
+    if (!results.maximum.empty()) {
+        int* maximum = results.maximum.data();
+        for (std::size_t row = 0; row < size; ++row)
+            maximum[row] = number[row] * qBound(1, sides[row] + luck[row], sides[row]) + bonus[row];
+    }
+
+    if (results.average.empty() && results.sigma.empty())
+        return;
+
+    // Same formulas as DiceRoll::average() and sigmaFromMoments() in there.
+    for (std::size_t row = 0; row < size; ++row) {
+        const Moments dice = oneDiceMoments(sides[row], luck[row]);
+        const double rollMean = number[row] * dice.mean + bonus[row];
+        const double rollVariance = number[row] * dice.variance;
+        const double p = probability[row];
+        const double mu = p * rollMean;
+        if (!results.average.empty())
+            results.average[row] = mu;
+        if (!results.sigma.empty()) {
+            const double deviation = rollMean - mu;
+            const double variance = p * (rollVariance + deviation * deviation)
+                                  + (1.0 - p) * mu * mu;
+            results.sigma[row] = qSqrt(std::max(0.0, variance));
+        }
+    }
+
+    // Resistance rounds the total, so those rows can't use the formulas above.
+    for (std::size_t row = 0; row < size; ++row) {
+        if (qFuzzyIsNull(columns.resistance[row]))
+            continue;
+        const DiceRoll roll = DiceRoll().number(number[row]).sides(sides[row])
+                                        .bonus(bonus[row]).luck(luck[row])
+                                        .resistance(columns.resistance[row])
+                                        .probability(probability[row]);
+        if (!results.average.empty())
+            results.average[row] = roll.average();
+        if (!results.sigma.empty())
+            results.sigma[row] = roll.sigma();
+    }
+}
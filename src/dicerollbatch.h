@@ -0,0 +1,62 @@
+/*
+ * This file is part of Moebius Toolkit.
+ * Copyright (C) 2026 Alejandro Exojo Piqueras
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <span>
+
+/*!
+ * Statistics of many rolls at once, taking each parameter of DiceRoll as a
+ * column (struct of arrays) instead of one DiceRoll object per roll.
+ *
+ * The rolls without resistance (the usual case) are calculated in one pass of
+ * closed formulas over the columns, without branching on the number of sides,
+ * so the compiler can vectorize it. The rows with resistance need the whole
+ * distribution for the sigma, so they are handed to DiceRoll (and its cache).
+ * The results are the same as DiceRoll::average(), sigma(), minimum() and
+ * maximum() for each row.
+ */
+namespace DiceRollBatch
+{
+
+struct Columns
+{
+    std::span<const int> number;
+    std::span<const int> sides;
+    std::span<const int> bonus;
+    std::span<const int> luck;
+    std::span<const double> resistance;
+    std::span<const double> probability;
+
+    /// The number of rows. All the columns must have the same size.
+    std::size_t size() const { return number.size(); }
+};
+
+/// Where to write the results. Each one can be left empty if not needed.
+struct Results
+{
+    std::span<double> average = {};
+    std::span<double> sigma = {};
+    std::span<int> minimum = {};
+    std::span<int> maximum = {};
+};
+
+void evaluate(const Columns& columns, const Results& results);
+
+}
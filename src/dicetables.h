@@ -0,0 +1,176 @@
+/*
+ * This file is part of Moebius Toolkit.
+ * Copyright (C) 2026 Alejandro Exojo Piqueras
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QtGlobal>
+
+#include <array>
+
+/*!
+ * Exact distributions of the dice that almost every weapon uses (1d2, 1d3, 1d4,
+ * 1d6, 1d8, 1d10, 1d12, 2d4, 2d6 and 1d20), for each luck value from -20 to
+ * +20. Everything is calculated at compile time, so DiceRoll can answer the
+ * common case without looping over the sides of the dice.
+ *
+ * The tables only have the dice part of the roll: no bonus, resistance or
+ * probability, which are applied later by DiceRoll.
+ */
+namespace DiceTables
+{
+
+constexpr int MinimumLuck = -20;
+constexpr int MaximumLuck = +20;
+constexpr int LuckValues = MaximumLuck - MinimumLuck + 1;
+// The biggest sum of all the dice in the tables (1d20 or 2d... up to 20).
+constexpr int MaximumValue = 20;
+
+struct Table
+{
+    int number = 0;
+    int sides = 0;
+    int luck = 0;
+    // Number of outcomes (sides^number) and how many sum up to each value.
+    int total = 0;
+    std::array<int, MaximumValue + 1> counts = {};
+    // Sum of the values, and of their squares, of each outcome. They give the
+    // mean and variance, which are what average() and sigma() need.
+    qint64 sum = 0;
+    qint64 squares = 0;
+
+    constexpr int first() const
+    {
+        int value = 0;
+        while (counts[value] == 0)
+            ++value;
+        return value;
+    }
+
+    constexpr int last() const
+    {
+        int value = MaximumValue;
+        while (counts[value] == 0)
+            --value;
+        return value;
+    }
+
+    constexpr double mean() const { return double(sum) / total; }
+    constexpr double variance() const { return double(squares) / total - mean() * mean(); }
+};
+
+namespace Detail
+{
+
+constexpr Table makeTable(int number, int sides, int luck)
+{
+    Table result;
+    result.number = number;
+    result.sides = sides;
+    result.luck = luck;
+
+    // Same as DiceRoll::luckified().
+    auto luckified = [&](int value) {
+        value += luck;
+        return value < 1 ? 1 : value > sides ? sides : value;
+    };
+
+    // Start with the certain 0, and add (convolve) one dice at a time.
+    std::array<int, MaximumValue + 1> counts = {};
+    counts[0] = 1;
+    for (int dice = 0; dice < number; ++dice) {
+        std::array<int, MaximumValue + 1> next = {};
+        for (int value = 0; value <= MaximumValue; ++value) {
+            if (counts[value] == 0)
+                continue;
+            for (int face = 1; face <= sides; ++face)
+                next[value + luckified(face)] += counts[value];
+        }
+        counts = next;
+    }
+
+    result.counts = counts;
+    for (int value = 0; value <= MaximumValue; ++value) {
+        result.total += counts[value];
+        result.sum += qint64(counts[value]) * value;
+        result.squares += qint64(counts[value]) * value * value;
+    }
+    return result;
+}
+
+template <int Number, int Sides>
+constexpr std::array<Table, LuckValues> makeTables()
+{
+    static_assert(Number * Sides <= MaximumValue);
+    std::array<Table, LuckValues> result = {};
+    for (int luck = MinimumLuck; luck <= MaximumLuck; ++luck)
+        result[luck - MinimumLuck] = makeTable(Number, Sides, luck);
+    return result;
+}
+
+inline constexpr auto table1d2  = makeTables<1, 2>();
+inline constexpr auto table1d3  = makeTables<1, 3>();
+inline constexpr auto table1d4  = makeTables<1, 4>();
+inline constexpr auto table1d6  = makeTables<1, 6>();
+inline constexpr auto table1d8  = makeTables<1, 8>();
+inline constexpr auto table1d10 = makeTables<1, 10>();
+inline constexpr auto table1d12 = makeTables<1, 12>();
+inline constexpr auto table2d4  = makeTables<2, 4>();
+inline constexpr auto table2d6  = makeTables<2, 6>();
+inline constexpr auto table1d20 = makeTables<1, 20>();
+
+}
+
+/// Returns the table of the roll, or nullptr if it's not one of the common ones.
+constexpr const Table* find(int number, int sides, int luck)
+{
+    // Luck beyond sides-1 can't move a dice any further, and the values from
+    // the tables would be the same, so use the closest one.
+    luck = luck < 1 - sides ? 1 - sides : luck > sides - 1 ? sides - 1 : luck;
+    if (luck < MinimumLuck || luck > MaximumLuck)
+        return nullptr;
+    const int index = luck - MinimumLuck;
+
+    using namespace Detail;
+    if (number == 1) {
+        switch (sides) {
+        case 2:  return &table1d2[index];
+        case 3:  return &table1d3[index];
+        case 4:  return &table1d4[index];
+        case 6:  return &table1d6[index];
+        case 8:  return &table1d8[index];
+        case 10: return &table1d10[index];
+        case 12: return &table1d12[index];
+        case 20: return &table1d20[index];
+        }
+    }
+    else if (number == 2) {
+        switch (sides) {
+        case 4: return &table2d4[index];
+        case 6: return &table2d6[index];
+        }
+    }
+    return nullptr;
+}
+
+static_assert(find(2, 6, 0)->counts[7] == 6);
+static_assert(find(2, 6, 0)->total == 36);
+static_assert(find(1, 20, +42)->first() == 20);
+static_assert(find(1, 8, 0)->sum == 36);
+static_assert(find(3, 6, 0) == nullptr);
+
+}
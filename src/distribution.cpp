@@ -0,0 +1,365 @@
+/*
+ * This file is part of Moebius Toolkit.
+ * Copyright (C) 2026 Alejandro Exojo Piqueras
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "distribution.h"
+
+#include "distributionkernels.h"
+
+#include <QDebug>
+#include <QtMath>
+
+#include <algorithm>
+#include <complex>
+#include <limits>
+#include <numeric>
+
+// Convolving directly costs the product of both sizes, so is the best for dice,
+// which have few sides. For big distributions (e.g. 40d4 convolved with 20d6),
+// it's cheaper to go through the Fast Fourier Transform, where the convolution
+// becomes a product, and the cost is only O(n log n) of the size of the result.
+namespace
+{
+    // Below this size of the smallest input, convolve directly.
+    constexpr int fftConvolutionThreshold = 64;
+    // Below this size of the result, power() just convolves repeatedly.
+    constexpr int fftPowerThreshold = 256;
+
+    using Complex = std::complex<double>;
+
+    // Iterative radix-2 Cooley-Tukey. The size must be a power of 2. The
+    // inverse is not divided by the size, as the caller normalizes anyway.
+    void fft(QVector<Complex>& data, bool inverse)
+    {
+        const int size = data.size();
+        Q_ASSERT(size > 0 && (size & (size - 1)) == 0);
+
+        for (int i = 1, j = 0; i < size; ++i) {
+            int bit = size >> 1;
+            for (; j & bit; bit >>= 1)
+                j ^= bit;
+            j ^= bit;
+            if (i < j)
+                std::swap(data[i], data[j]);
+        }
+
+        // Each twiddle factor calculated directly, instead of multiplying the
+        // previous one, which accumulates the rounding errors.
+        QVector<Complex> twiddles(size / 2);
+        const double sign = inverse ? 1.0 : -1.0;
+        for (int k = 0; k < size / 2; ++k)
+            twiddles[k] = std::polar(1.0, sign * 2 * M_PI * k / size);
+
+        for (int length = 2; length <= size; length <<= 1) {
+            const int half = length / 2;
+            const int stride = size / length;
+            for (int start = 0; start < size; start += length) {
+                for (int k = 0; k < half; ++k) {
+                    const Complex even = data[start + k];
+                    const Complex odd = data[start + k + half] * twiddles[k * stride];
+                    data[start + k] = even + odd;
+                    data[start + k + half] = even - odd;
+                }
+            }
+        }
+    }
+
+    int fftSize(int resultSize)
+    {
+        int result = 1;
+        while (result < resultSize)
+            result <<= 1;
+        return result;
+    }
+
+    QVector<Complex> transformed(const QVector<double>& values, int size)
+    {
+        QVector<Complex> result(size, Complex());
+        for (int index = 0, last = values.size(); index < last; ++index)
+            result[index] = values.at(index);
+        fft(result, false);
+        return result;
+    }
+
+    // If any value in the middle is impossible, the result might have gaps too.
+    bool hasGaps(const QVector<double>& values)
+    {
+        return std::find(values.begin(), values.end(), 0.0) != values.end();
+    }
+
+    QVector<double> indicator(const QVector<double>& values)
+    {
+        QVector<double> result(values.size());
+        for (int index = 0, size = values.size(); index < size; ++index)
+            result[index] = values.at(index) == 0.0 ? 0.0 : 1.0;
+        return result;
+    }
+
+    // The FFT leaves some noise of the order of the machine epsilon times the
+    // biggest value, so values that can't happen get a tiny probability (even
+    // negative), and the ones that can but are tiny can get a 0 or negative.
+    // With the support known exactly, the first are removed, and the second get
+    // the smallest probability there is, which is closer to the truth than 0.
+    // Then everything is scaled so it adds up to the same as the inputs.
+    QVector<double> cleaned(const QVector<Complex>& data, int resultSize,
+                            const QVector<bool>& support, double total)
+    {
+        QVector<double> result(resultSize);
+        double sum = 0.0;
+        for (int index = 0; index < resultSize; ++index) {
+            const bool possible = support.isEmpty() || support.at(index);
+            result[index] = possible ? qMax(data.at(index).real(), std::numeric_limits<double>::min())
+                                     : 0.0;
+            sum += result[index];
+        }
+        DistributionKernels::native().scale(result.data(), resultSize, total / sum);
+        return result;
+    }
+
+    QVector<double> fftConvolution(const QVector<double>& a, const QVector<double>& b)
+    {
+        const int resultSize = a.size() + b.size() - 1;
+        const int size = fftSize(resultSize);
+
+        auto product = [&](const QVector<double>& x, const QVector<double>& y) {
+            QVector<Complex> result = transformed(x, size);
+            const QVector<Complex> other = transformed(y, size);
+            for (int index = 0; index < size; ++index)
+                result[index] *= other.at(index);
+            fft(result, true);
+            return result;
+        };
+
+        // The support is the convolution of where each input is possible. Those
+        // are counts of combinations (integers), so rounding can't get them wrong.
+        QVector<bool> support;
+        if (hasGaps(a) || hasGaps(b)) {
+            const QVector<Complex> counts = product(indicator(a), indicator(b));
+            support.resize(resultSize);
+            for (int index = 0; index < resultSize; ++index)
+                support[index] = counts.at(index).real() / size > 0.5;
+        }
+
+        const double total = std::accumulate(a.begin(), a.end(), 0.0)
+                           * std::accumulate(b.begin(), b.end(), 0.0);
+        return cleaned(product(a, b), resultSize, support, total);
+    }
+}
+
+Distribution::Distribution(int first, const QVector<double>& probabilities)
+    : m_first(first)
+    , m_probabilities(probabilities)
+{
+    // Trim the values that can't happen (e.g. rolling a 1 with luck), so the
+    // range is the one of the values that really can happen.
+    int begin = 0;
+    int end = m_probabilities.size();
+    while (begin < end && m_probabilities.at(begin) == 0.0)
+        ++begin;
+    while (end > begin && m_probabilities.at(end - 1) == 0.0)
+        --end;
+    Q_ASSERT(begin != end);
+    if (begin != 0 || end != m_probabilities.size()) {
+        m_probabilities = m_probabilities.mid(begin, end - begin);
+        m_first += begin;
+    }
+}
+
+double Distribution::probability(int value) const
+{
+    return m_probabilities.value(value - m_first, 0.0);
+}
+
+double Distribution::mean() const
+{
+    double result = 0.0;
+    for (int index = 0, size = m_probabilities.size(); index < size; ++index)
+        result += (m_first + index) * m_probabilities.at(index);
+    return result;
+}
+
+double Distribution::variance() const
+{
+    const double mu = mean();
+    double result = 0.0;
+    for (int index = 0, size = m_probabilities.size(); index < size; ++index) {
+        const double deviation = (m_first + index) - mu;
+        result += m_probabilities.at(index) * deviation * deviation;
+    }
+    return result;
+}
+
+Distribution Distribution::convolved(const Distribution& other) const
+{
+    // The kernel vectorizes the inner loop, so that one should be the longest.
+    const bool longer = size() >= other.size();
+    const QVector<double>& a = longer ? other.m_probabilities : m_probabilities;
+    const QVector<double>& b = longer ? m_probabilities : other.m_probabilities;
+
+    if (a.size() >= fftConvolutionThreshold)
+        return Distribution(m_first + other.m_first, fftConvolution(a, b));
+
+    QVector<double> result(a.size() + b.size() - 1, 0.0);
+    DistributionKernels::native().convolve(a.constData(), a.size(),
+                                           b.constData(), b.size(), result.data());
+    return Distribution(m_first + other.m_first, result);
+}
+
+// The FFT of the sum of N values is the FFT of one raised to the Nth power, so
+// a big pool costs a single transform and its inverse. Without gaps in the
+// input, every value between N*first() and N*last() is possible.
+Distribution Distribution::power(int times) const
+{
+    Q_ASSERT(times >= 0);
+    const int resultSize = times * (size() - 1) + 1;
+
+    if (resultSize < fftPowerThreshold || hasGaps(m_probabilities)) {
+        // Exponentiation by squaring: log2(times) convolutions, which also take
+        // the FFT path of convolved() once they get big enough.
+        Distribution result;
+        Distribution square = *this;
+        for (int remaining = times; remaining > 0; remaining >>= 1) {
+            if (remaining & 1)
+                result = result.convolved(square);
+            if (remaining > 1)
+                square = square.convolved(square);
+        }
+        return result;
+    }
+
+    const int size = fftSize(resultSize);
+    QVector<Complex> data = transformed(m_probabilities, size);
+    for (Complex& value : data)
+        value = std::pow(value, times);
+    fft(data, true);
+
+    const double total = qPow(std::accumulate(m_probabilities.begin(),
+                                              m_probabilities.end(), 0.0), times);
+    // Scaling by the size happens when normalizing in cleaned().
+    return Distribution(m_first * times, cleaned(data, resultSize, {}, total));
+}
+
+Distribution Distribution::shifted(int offset) const
+{
+    Distribution result = *this;
+    result.m_first += offset;
+    return result;
+}
+
+Distribution Distribution::remapped(const QVector<int>& values) const
+{
+    Q_ASSERT(values.size() == size());
+    // Resistance and luck never make a value lower than a smaller one, so the
+    // common case doesn't need to look for the new range.
+    int first = values.first();
+    int last = values.last();
+    if (!std::is_sorted(values.begin(), values.end())) {
+        const auto [minimum, maximum] = std::minmax_element(values.begin(), values.end());
+        first = *minimum;
+        last = *maximum;
+    }
+
+    QVector<double> probabilities(last - first + 1, 0.0);
+    for (int index = 0, size = values.size(); index < size; ++index)
+        probabilities[values.at(index) - first] += m_probabilities.at(index);
+    return Distribution(first, probabilities);
+}
+
+Distribution Distribution::mixed(double probability, const Distribution& otherwise) const
+{
+    Q_ASSERT(probability >= 0.0 && probability <= 1.0);
+    if (probability == 1.0)
+        return *this;
+    if (probability == 0.0)
+        return otherwise;
+
+    const int first = qMin(m_first, otherwise.m_first);
+    const int last = qMax(this->last(), otherwise.last());
+    QVector<double> result(last - first + 1, 0.0);
+    const auto& kernels = DistributionKernels::native();
+    kernels.accumulate(result.data() + m_first - first, m_probabilities.constData(),
+                       size(), probability);
+    kernels.accumulate(result.data() + otherwise.m_first - first,
+                       otherwise.m_probabilities.constData(), otherwise.size(),
+                       1.0 - probability);
+    return Distribution(first, result);
+}
+
+Distribution Distribution::mixed(double probability) const
+{
+    return mixed(probability, Distribution());
+}
+
+// Each side is summed separately, instead of using 1-x of the other, so the
+// probabilities of the tails are accurate even when they are really small.
+CumulativeDistribution::CumulativeDistribution(const Distribution& distribution)
+    : m_first(distribution.first())
+{
+    const QVector<double>& probabilities = distribution.probabilities();
+    const int size = probabilities.size();
+    m_atMost.resize(size);
+    m_atLeast.resize(size);
+    std::partial_sum(probabilities.begin(), probabilities.end(), m_atMost.begin());
+    std::partial_sum(probabilities.rbegin(), probabilities.rend(), m_atLeast.rbegin());
+}
+
+double CumulativeDistribution::probabilityAtMost(int value) const
+{
+    if (value < m_first)
+        return 0.0;
+    return m_atMost.at(qMin(value, last()) - m_first);
+}
+
+double CumulativeDistribution::probabilityAtLeast(int value) const
+{
+    if (value > last())
+        return 0.0;
+    return m_atLeast.at(qMax(value, m_first) - m_first);
+}
+
+int CumulativeDistribution::quantile(double probability) const
+{
+    Q_ASSERT(probability >= 0.0 && probability <= 1.0);
+    // The sums have some rounding error, so 3d6 could end up with a chance of
+    // 0.4999999 of 10 or less, and the median would be 11 instead of 10.
+    const double target = probability - 1e-12;
+    const auto found = std::lower_bound(m_atMost.begin(), m_atMost.end(), target);
+    if (found == m_atMost.end())
+        return last();
+    return m_first + int(found - m_atMost.begin());
+}
+
+bool operator==(const Distribution& a, const Distribution& b)
+{
+    if (a.first() != b.first() || a.size() != b.size())
+        return false;
+    for (int index = 0, size = a.size(); index < size; ++index) {
+        // qFuzzyCompare can't deal well with 0.0. Shifting both is fine.
+        if (!qFuzzyCompare(a.probabilities().at(index) + 1.0,
+                           b.probabilities().at(index) + 1.0))
+            return false;
+    }
+    return true;
+}
+
+QDebug operator<<(QDebug debug, const Distribution& distribution)
+{
+    QDebugStateSaver saver(debug);
+    debug.nospace() << "Distribution(" << distribution.first() << ".."
+                    << distribution.last() << ": " << distribution.probabilities() << ")";
+    return debug;
+}
@@ -0,0 +1,125 @@
+/*
+ * This file is part of Moebius Toolkit.
+ * Copyright (C) 2026 Alejandro Exojo Piqueras
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QVector>
+
+class QDebug;
+
+/*!
+ * \brief Dense Probability Mass Function over a range of integer values
+ *
+ * The entry at index 0 of probabilities() is the probability of the value
+ * first(), the next one of first()+1, and so on until last(). The edges never
+ * hold a probability of exactly 0, so first() and last() are the actual
+ * minimum and maximum that can happen.
+ *
+ * A default constructed distribution is the certain outcome of 0, which is the
+ * neutral element of convolved() (adding nothing), and what happens when an
+ * effect doesn't apply (see mixed()).
+ */
+class Distribution
+{
+public:
+    explicit Distribution() = default;
+    explicit Distribution(int first, const QVector<double>& probabilities);
+
+    [[nodiscard]] inline int first() const {return m_first;}
+    [[nodiscard]] inline int last() const {return m_first + m_probabilities.size() - 1;}
+    [[nodiscard]] inline int size() const {return m_probabilities.size();}
+    [[nodiscard]] inline const QVector<double>& probabilities() const {return m_probabilities;}
+
+    double probability(int value) const;
+    double mean() const;
+    double variance() const;
+
+    /// Distribution of the sum of a value from this and one from \a other.
+    Distribution convolved(const Distribution& other) const;
+    /// Distribution of the sum of \a times values from this (e.g. 10d6 from 1d6).
+    Distribution power(int times) const;
+    /// All the values are moved by \a offset (e.g. a bonus to a dice roll).
+    Distribution shifted(int offset) const;
+    /// Happens with \a probability, otherwise \a otherwise happens instead.
+    Distribution mixed(double probability, const Distribution& otherwise) const;
+    /// Happens with \a probability, otherwise the result is 0.
+    Distribution mixed(double probability) const;
+    /// The values are transformed by \a function (e.g. applying resistance),
+    /// and the probabilities of values that end up being the same get merged.
+    template <typename Function>
+    Distribution mapped(Function function) const;
+    /// Same as mapped(), but with the new values precomputed in \a values,
+    /// one for each value from first() to last(), which is cheaper when the
+    /// same table is used many times, or the function is expensive.
+    Distribution remapped(const QVector<int>& values) const;
+
+private:
+    int m_first = 0;
+    QVector<double> m_probabilities = {1.0};
+};
+
+template <typename Function>
+Distribution Distribution::mapped(Function function) const
+{
+    int first = function(m_first);
+    int last = first;
+    for (int value = m_first + 1, end = this->last(); value <= end; ++value) {
+        const int result = function(value);
+        first = qMin(first, result);
+        last = qMax(last, result);
+    }
+
+    QVector<double> probabilities(last - first + 1, 0.0);
+    for (int index = 0, size = m_probabilities.size(); index < size; ++index)
+        probabilities[function(m_first + index) - first] += m_probabilities.at(index);
+    return Distribution(first, probabilities);
+}
+
+/*!
+ * \brief Cumulative form of a Distribution, for queries about ranges of values
+ *
+ * Built once from the PMF (a running sum from each side), so asking for the
+ * probability of getting at least some value is a lookup, and the quantiles a
+ * binary search.
+ */
+class CumulativeDistribution
+{
+public:
+    explicit CumulativeDistribution() = default;
+    explicit CumulativeDistribution(const Distribution& distribution);
+
+    [[nodiscard]] inline int first() const {return m_first;}
+    [[nodiscard]] inline int last() const {return m_first + m_atMost.size() - 1;}
+
+    /// Probability of a value lower or equal than \a value.
+    double probabilityAtMost(int value) const;
+    /// Probability of a value greater or equal than \a value.
+    double probabilityAtLeast(int value) const;
+    /// The lowest value with a probabilityAtMost() of at least \a probability
+    /// (e.g. 0.5 is the median, 0.9 the 90th percentile).
+    int quantile(double probability) const;
+
+private:
+    int m_first = 0;
+    QVector<double> m_atMost = {1.0};
+    QVector<double> m_atLeast = {1.0};
+};
+
+bool operator==(const Distribution& a, const Distribution& b);
+
+QDebug operator<<(QDebug debug, const Distribution& distribution);
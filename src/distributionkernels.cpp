@@ -0,0 +1,148 @@
+/*
+ * This file is part of Moebius Toolkit.
+ * Copyright (C) 2026 Alejandro Exojo Piqueras
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "distributionkernels.h"
+
+#include <QtGlobal>
+
+#if defined(Q_PROCESSOR_X86) && (defined(Q_CC_GNU) || defined(Q_CC_CLANG) || defined(Q_CC_MSVC))
+#  define MOEBIUS_KERNELS_AVX2
+#  include <immintrin.h>
+#  if defined(Q_CC_MSVC)
+#    include <intrin.h>
+     // MSVC allows AVX intrinsics in any function, no need to mark them.
+#    define MOEBIUS_TARGET_AVX2
+#  else
+#    define MOEBIUS_TARGET_AVX2 __attribute__((target("avx2")))
+#  endif
+#endif
+
+using namespace DistributionKernels;
+
+namespace
+{
+
+void convolveScalar(const double* a, int aSize, const double* b, int bSize, double* output)
+{
+    for (int i = 0; i < aSize; ++i) {
+        const double factor = a[i];
+        double* row = output + i;
+        for (int j = 0; j < bSize; ++j)
+            row[j] += factor * b[j];
+    }
+}
+
+void scaleScalar(double* data, int size, double factor)
+{
+    for (int i = 0; i < size; ++i)
+        data[i] *= factor;
+}
+
+void accumulateScalar(double* output, const double* input, int size, double weight)
+{
+    for (int i = 0; i < size; ++i)
+        output[i] += weight * input[i];
+}
+
+const Implementation scalarImplementation = {
+    "scalar", convolveScalar, scaleScalar, accumulateScalar
+};
+
+#ifdef MOEBIUS_KERNELS_AVX2
+
+MOEBIUS_TARGET_AVX2
+void accumulateAvx2(double* output, const double* input, int size, double weight)
+{
+    const __m256d factor = _mm256_set1_pd(weight);
+    int i = 0;
+    for (; i + 4 <= size; i += 4) {
+        const __m256d product = _mm256_mul_pd(factor, _mm256_loadu_pd(input + i));
+        _mm256_storeu_pd(output + i, _mm256_add_pd(_mm256_loadu_pd(output + i), product));
+    }
+    for (; i < size; ++i)
+        output[i] += weight * input[i];
+}
+
+// Each value of a (the smaller one, ideally) scales the whole b, and the result
+// is added to the output at its offset. That's the same as accumulate().
+MOEBIUS_TARGET_AVX2
+void convolveAvx2(const double* a, int aSize, const double* b, int bSize, double* output)
+{
+    for (int i = 0; i < aSize; ++i)
+        accumulateAvx2(output + i, b, bSize, a[i]);
+}
+
+MOEBIUS_TARGET_AVX2
+void scaleAvx2(double* data, int size, double factor)
+{
+    const __m256d multiplier = _mm256_set1_pd(factor);
+    int i = 0;
+    for (; i + 4 <= size; i += 4)
+        _mm256_storeu_pd(data + i, _mm256_mul_pd(_mm256_loadu_pd(data + i), multiplier));
+    for (; i < size; ++i)
+        data[i] *= factor;
+}
+
+const Implementation avx2Implementation = {
+    "avx2", convolveAvx2, scaleAvx2, accumulateAvx2
+};
+
+bool hasAvx2()
+{
+#if defined(Q_CC_MSVC)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+        return false;
+    // The CPU has AVX, and the OS saves the AVX registers (OSXSAVE and XCR0).
+    __cpuid(info, 1);
+    if (!(info[2] & (1 << 27)) || !(info[2] & (1 << 28)))
+        return false;
+    if ((_xgetbv(0) & 0x6) != 0x6)
+        return false;
+    __cpuidex(info, 7, 0);
+    return info[1] & (1 << 5);
+#else
+    // This already checks that the OS supports the registers.
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+#endif
+
+const Implementation& detect()
+{
+#ifdef MOEBIUS_KERNELS_AVX2
+    if (hasAvx2())
+        return avx2Implementation;
+#endif
+    return scalarImplementation;
+}
+
+}
+
+const Implementation& DistributionKernels::scalar()
+{
+    return scalarImplementation;
+}
+
+const Implementation& DistributionKernels::native()
+{
+    static const Implementation& result = detect();
+    return result;
+}
@@ -0,0 +1,47 @@
+/*
+ * This file is part of Moebius Toolkit.
+ * Copyright (C) 2026 Alejandro Exojo Piqueras
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+/*!
+ * The inner loops of Distribution, over plain arrays of probabilities.
+ *
+ * There is a portable implementation, and one using AVX2 on x86 processors
+ * that support it. native() chooses the best one for the running CPU (once,
+ * when first called), and it's what Distribution uses. The vectorized code
+ * does the same operations in the same order as the scalar one (no fused
+ * multiply-add), so both give exactly the same results.
+ */
+namespace DistributionKernels
+{
+
+struct Implementation
+{
+    const char* name;
+    /// output[i+j] += a[i] * b[j]. The output has aSize+bSize-1 entries.
+    void (*convolve)(const double* a, int aSize, const double* b, int bSize, double* output);
+    /// data[i] *= factor
+    void (*scale)(double* data, int size, double factor);
+    /// output[i] += weight * input[i], the building block of a mixture.
+    void (*accumulate)(double* output, const double* input, int size, double weight);
+};
+
+const Implementation& scalar();
+const Implementation& native();
+
+}
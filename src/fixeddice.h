@@ -0,0 +1,113 @@
+/*
+ * This file is part of Moebius Toolkit.
+ * Copyright (C) 2026 Alejandro Exojo Piqueras
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <utility>
+
+/*!
+ * \brief Statistics of a roll of a shape known at compile time
+ *
+ * The faces are expanded with a fold expression, so average() has no loop,
+ * and it can be evaluated at compile time as well. It gives the same results
+ * as DiceRoll::average(), with luck, bonus, resistance and probability.
+ *
+ * FixedDiceDispatch::average() routes a runtime roll to the matching shape,
+ * which covers almost every weapon (the same ones as DiceTables).
+ */
+template <int Number, int Sides>
+struct FixedDice
+{
+    static_assert(Number >= 0 && Sides >= 1);
+    static constexpr int number = Number;
+    static constexpr int sides = Sides;
+
+    static constexpr int luckified(int face, int luck)
+    {
+        const int value = face + luck;
+        return value < 1 ? 1 : value > Sides ? Sides : value;
+    }
+
+    static constexpr int minimum(int bonus, int luck) { return Number * luckified(1, luck) + bonus; }
+    static constexpr int maximum(int bonus, int luck) { return Number * luckified(Sides, luck) + bonus; }
+
+    static constexpr double average(int bonus, int luck, double resistance, double probability)
+    {
+        // Same order of operations than DiceRoll::calculateAverage(), so the
+        // rounding is the same too.
+        return sum(bonus, luck, 1 - resistance, std::make_integer_sequence<int, Sides>()) / Sides
+             * probability;
+    }
+
+private:
+    // Same as qCeil(), which is not constexpr.
+    static constexpr int ceiling(double value)
+    {
+        const int truncated = int(value);
+        return value > truncated ? truncated + 1 : truncated;
+    }
+
+    template <int... Faces>
+    static constexpr double sum(int bonus, int luck, double factor,
+                                std::integer_sequence<int, Faces...>)
+    {
+        return (0.0 + ... + ceiling((Number * luckified(Faces + 1, luck) + bonus) * factor));
+    }
+};
+
+static_assert(FixedDice<1, 6>::average(0, 0, 0.0, 1.0) == 3.5);
+static_assert(FixedDice<2, 6>::average(1, 0, 0.0, 0.5) == 4.0);
+static_assert(FixedDice<1, 20>::average(0, +19, 0.0, 1.0) == 20.0);
+static_assert(FixedDice<1, 4>::average(0, 0, 0.5, 1.0) == 1.5); // 1, 1, 2, 2
+static_assert(FixedDice<1, 8>::minimum(2, 3) == 6);
+
+namespace FixedDiceDispatch
+{
+
+/// If the roll has one of the common shapes, sets \a result to the average,
+/// and returns true. Otherwise it returns false, and \a result is untouched.
+constexpr bool average(int number, int sides, int bonus, int luck, double resistance,
+                       double probability, double& result)
+{
+    auto use = [&](auto dice) {
+        result = decltype(dice)::average(bonus, luck, resistance, probability);
+        return true;
+    };
+
+    if (number == 1) {
+        switch (sides) {
+        case 2:  return use(FixedDice<1, 2>());
+        case 3:  return use(FixedDice<1, 3>());
+        case 4:  return use(FixedDice<1, 4>());
+        case 6:  return use(FixedDice<1, 6>());
+        case 8:  return use(FixedDice<1, 8>());
+        case 10: return use(FixedDice<1, 10>());
+        case 12: return use(FixedDice<1, 12>());
+        case 20: return use(FixedDice<1, 20>());
+        }
+    }
+    else if (number == 2) {
+        switch (sides) {
+        case 4: return use(FixedDice<2, 4>());
+        case 6: return use(FixedDice<2, 6>());
+        }
+    }
+    return false;
+}
+
+}
@@ -17,22 +17,43 @@ HEADERS = \
     backstabstats.h \
     bifffile.h \
     calculators.h \
+    damageexpression.h \
+    damagegraph.h \
+    damagesweep.h \
+    dicecounts.h \
     diceroll.h \
+    dicerollbatch.h \
+    dicetables.h \
+    distribution.h \
+    distributionkernels.h \
+    fixeddice.h \
     keyfile.h \
+    montecarlo.h \
     packed.h \
     resourcemanager.h \
     resourcetype.h \
+    roundstokill.h \
     tdafile.h \
     tlkfile.h \
+    weaponoptimizer.h \
     xplevels.h \
 
 SOURCES = \
     backstabstats.cpp \
     bifffile.cpp \
     calculators.cpp \
+    damageexpression.cpp \
+    damagegraph.cpp \
+    damagesweep.cpp \
     diceroll.cpp \
+    dicerollbatch.cpp \
+    distribution.cpp \
+    distributionkernels.cpp \
     keyfile.cpp \
+    montecarlo.cpp \
     resourcemanager.cpp \
+    roundstokill.cpp \
     tdafile.cpp \
     tlkfile.cpp \
+    weaponoptimizer.cpp \
     xplevels.cpp \
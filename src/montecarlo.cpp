@@ -0,0 +1,244 @@
+/*
+ * This file is part of Moebius Toolkit.
+ * Copyright (C) 2026 Alejandro Exojo Piqueras
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "montecarlo.h"
+
+#include "diceroll.h"
+
+#include <QThread>
+#include <QtMath>
+
+#ifndef Q_OS_WASM
+#include <QAtomicInt>
+#include <QThreadPool>
+#endif
+
+using namespace MonteCarlo;
+using namespace Calculators;
+
+namespace
+{
+    // Each chunk is one stream of the generator, and the unit of work that the
+    // threads take. Big enough to not make the threads contend for the next one.
+    constexpr qint64 chunkSize = 1 << 16;
+
+    // Mean and sum of squared deviations, updated one sample at a time with
+    // Welford's method, and merged with the formula of Chan et al.
+    struct Accumulator
+    {
+        qint64 count = 0;
+        double mean = 0.0;
+        double squares = 0.0;
+
+        void add(double value)
+        {
+            ++count;
+            const double delta = value - mean;
+            mean += delta / count;
+            squares += delta * (value - mean);
+        }
+
+        void merge(const Accumulator& other)
+        {
+            if (other.count == 0)
+                return;
+            const qint64 total = count + other.count;
+            const double delta = other.mean - mean;
+            mean += delta * other.count / total;
+            squares += other.squares + delta * delta * count * other.count / total;
+            count = total;
+        }
+    };
+
+    template <typename Sample>
+    Estimate run(const Options& options, Sample sample)
+    {
+        Q_ASSERT(options.samples > 0);
+        const int chunks = int((options.samples + chunkSize - 1) / chunkSize);
+        QVector<Accumulator> results(chunks);
+
+        auto runChunk = [&](int chunk) {
+            Philox random(options.seed, quint64(chunk));
+            const qint64 count = qMin(chunkSize, options.samples - chunk * chunkSize);
+            Accumulator& result = results[chunk];
+            for (qint64 index = 0; index < count; ++index)
+                result.add(sample(random));
+        };
+
+#ifndef Q_OS_WASM
+        const int threads = int(qMin<qint64>(options.threads > 0 ? options.threads
+                                                             : QThread::idealThreadCount(),
+                                             chunks));
+        if (threads > 1) {
+            QAtomicInt next = 0;
+            QThreadPool pool;
+            pool.setMaxThreadCount(threads);
+            for (int thread = 0; thread < threads; ++thread) {
+                pool.start([&] {
+                    for (int chunk = next.fetchAndAddRelaxed(1); chunk < chunks;
+                         chunk = next.fetchAndAddRelaxed(1))
+                    {
+                        runChunk(chunk);
+                    }
+                });
+            }
+            pool.waitForDone();
+        }
+        else
+#endif
+        {
+            for (int chunk = 0; chunk < chunks; ++chunk)
+                runChunk(chunk);
+        }
+
+        // Always merged in the same order, so the rounding is the same too.
+        Accumulator total;
+        for (const Accumulator& result : results)
+            total.merge(result);
+
+        Estimate estimate;
+        estimate.samples = total.count;
+        estimate.mean = total.mean;
+        estimate.variance = total.count > 1 ? total.squares / (total.count - 1) : 0.0;
+        return estimate;
+    }
+
+    // The Philox constants: multipliers for the S-box, and the Weyl sequence
+    // to bump the key on each round (golden ratio and sqrt(3)-1).
+    constexpr quint32 multiplier0 = 0xD2511F53;
+    constexpr quint32 multiplier1 = 0xCD9E8D57;
+    constexpr quint32 weyl0 = 0x9E3779B9;
+    constexpr quint32 weyl1 = 0xBB67AE85;
+
+    inline void multiply(quint32 a, quint32 b, quint32& high, quint32& low)
+    {
+        const quint64 product = quint64(a) * b;
+        high = quint32(product >> 32);
+        low = quint32(product);
+    }
+}
+
+Philox::Philox(quint64 seed, quint64 stream)
+    : m_counter{0, 0, quint32(stream), quint32(stream >> 32)}
+    , m_key{quint32(seed), quint32(seed >> 32)}
+{
+}
+
+Philox::Counter Philox::block(Counter counter, Key key)
+{
+    for (int round = 0; round < 10; ++round) {
+        quint32 high0, low0, high1, low1;
+        multiply(multiplier0, counter[0], high0, low0);
+        multiply(multiplier1, counter[2], high1, low1);
+        counter = {high1 ^ counter[1] ^ key[0], low1, high0 ^ counter[3] ^ key[1], low0};
+        key[0] += weyl0;
+        key[1] += weyl1;
+    }
+    return counter;
+}
+
+quint32 Philox::operator()()
+{
+    if (m_used == 4) {
+        m_block = block(m_counter, m_key);
+        m_used = 0;
+        // The first two words are the position in the stream.
+        if (++m_counter[0] == 0)
+            ++m_counter[1];
+    }
+    return m_block[m_used++];
+}
+
+// https://arxiv.org/abs/1805.10941 The high part of random*bound is uniform,
+// except for a few low parts, which are rejected.
+quint32 Philox::bounded(quint32 bound)
+{
+    Q_ASSERT(bound > 0);
+    quint64 product = quint64((*this)()) * bound;
+    quint32 low = quint32(product);
+    if (low < bound) {
+        const quint32 threshold = quint32(-bound) % bound;
+        while (low < threshold) {
+            product = quint64((*this)()) * bound;
+            low = quint32(product);
+        }
+    }
+    return quint32(product >> 32);
+}
+
+double Philox::uniform()
+{
+    const quint64 bits = (quint64((*this)()) << 32 | (*this)()) >> 11;
+    return bits * 0x1.0p-53;
+}
+
+double Estimate::sigma() const
+{
+    return qSqrt(variance);
+}
+
+double Estimate::standardError() const
+{
+    return samples > 0 ? qSqrt(variance / samples) : 0.0;
+}
+
+int MonteCarlo::sample(const DiceRoll& roll, Philox& random)
+{
+    // Decided first, as the roll doesn't matter if the effect doesn't happen.
+    if (roll.probability() < 1.0 && random.uniform() >= roll.probability())
+        return 0;
+    int result = roll.bonus();
+    for (int dice = 0; dice < roll.number(); ++dice)
+        result += roll.luckified(1 + int(random.bounded(quint32(roll.sides()))));
+    return roll.resistified(result);
+}
+
+int MonteCarlo::sample(const Damage& damage, const Attack& attack, Philox& random)
+{
+    const int outcome = damage.hit(attack.hand, attack.ac, 1 + int(random.bounded(20)));
+    if (outcome == 0)
+        return 0;
+    const Damage::Stat stat = outcome == 2 ? attack.critical : Damage::Regular;
+
+    // Same as Damage::onHitDamages(): only the physical damage gets the
+    // bonuses, and gets doubled on a critical hit.
+    const WeaponArrangement& arrangement = damage.arrangement(attack.hand);
+    int result = 0;
+    for (auto entry = arrangement.damage.constBegin(), last = arrangement.damage.constEnd();
+         entry != last; ++entry)
+    {
+        if (entry.key() & DamageType::ElementalBit) {
+            result += sample(entry.value(), random);
+        } else {
+            DiceRoll physical = arrangement.physicalDamage();
+            physical.bonus(physical.bonus() + damage.common().damageBonuses());
+            result += sample(physical, random) * (stat == Damage::Regular ? 1 : 2);
+        }
+    }
+    return result;
+}
+
+Estimate MonteCarlo::estimate(const DiceRoll& roll, const Options& options)
+{
+    return run(options, [&roll](Philox& random) { return sample(roll, random); });
+}
+
+Estimate MonteCarlo::estimate(const Damage& damage, const Attack& attack, const Options& options)
+{
+    return run(options, [&](Philox& random) { return sample(damage, attack, random); });
+}
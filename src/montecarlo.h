@@ -0,0 +1,121 @@
+/*
+ * This file is part of Moebius Toolkit.
+ * Copyright (C) 2026 Alejandro Exojo Piqueras
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QtGlobal>
+
+#include <array>
+
+#include "calculators.h"
+
+class DiceRoll;
+
+/*!
+ * Estimates of the statistics of rolls and attacks by simulating them, to
+ * check the exact calculations, and for the cases too complex for them.
+ *
+ * The random numbers come from Philox4x32-10, a counter based generator: the
+ * n-th number of a stream is a function of the key (the seed) and n, so any
+ * part of the sequence can be generated without the previous ones. The samples
+ * are split in chunks, each one with its own counter range, and the threads
+ * take the chunks in whatever order, but the results of the chunks are merged
+ * in order. So the same seed gives exactly the same estimate, no matter the
+ * number of threads.
+ */
+namespace MonteCarlo
+{
+
+/*!
+ * \brief Philox4x32 with 10 rounds, from "Parallel random numbers: as easy as
+ * 1, 2, 3" (Salmon et al., SC'11)
+ */
+class Philox
+{
+public:
+    using Counter = std::array<quint32, 4>;
+    using Key = std::array<quint32, 2>;
+
+    /// Stream \a stream of the generator seeded with \a seed.
+    explicit Philox(quint64 seed, quint64 stream = 0);
+
+    /// The raw block cipher: the random block for the given counter and key.
+    static Counter block(Counter counter, Key key);
+
+    /// Next 32 random bits of the stream.
+    quint32 operator()();
+    /// Uniform in [0, bound) without bias (Lemire's method).
+    quint32 bounded(quint32 bound);
+    /// Uniform in [0, 1), with 53 random bits.
+    double uniform();
+
+private:
+    Counter m_counter = {};
+    Key m_key = {};
+    Counter m_block = {};
+    int m_used = 4;
+};
+
+struct Options
+{
+    qint64 samples = 1000000;
+    quint64 seed = 0;
+    /// 0 uses as many threads as cores.
+    int threads = 0;
+};
+
+/*!
+ * \brief Mean and variance of a sample, and the confidence interval of the mean
+ */
+struct Estimate
+{
+    qint64 samples = 0;
+    double mean = 0.0;
+    double variance = 0.0;
+
+    double sigma() const;
+    double standardError() const;
+    /// Interval of the mean, \a z standard errors around it. The default is
+    /// the usual 99.9% one. The sample is big enough to use the normal.
+    double lower(double z = 3.29) const { return mean - z * standardError(); }
+    double upper(double z = 3.29) const { return mean + z * standardError(); }
+    bool contains(double value, double z = 3.29) const
+    {
+        return value >= lower(z) && value <= upper(z);
+    }
+};
+
+/// The damage of one attack of \a hand against \a ac (0 when it misses).
+struct Attack
+{
+    Calculators::Damage::Hand hand = Calculators::Damage::One;
+    int ac = 0;
+    /// What a critical hit does to the damage (helmets prevent the doubling).
+    Calculators::Damage::Stat critical = Calculators::Damage::Critical;
+};
+
+/// One value of the roll, with the same rules as DiceRoll::distribution().
+int sample(const DiceRoll& roll, Philox& random);
+/// One attack, with the same rules as Damage::hitDistribution() and onHitDamages().
+int sample(const Calculators::Damage& damage, const Attack& attack, Philox& random);
+
+Estimate estimate(const DiceRoll& roll, const Options& options = {});
+Estimate estimate(const Calculators::Damage& damage, const Attack& attack,
+                  const Options& options = {});
+
+}
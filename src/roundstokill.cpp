@@ -0,0 +1,153 @@
+/*
+ * This file is part of Moebius Toolkit.
+ * Copyright (C) 2026 Alejandro Exojo Piqueras
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "roundstokill.h"
+
+#include "distribution.h"
+#include "distributionkernels.h"
+
+#include <QtNumeric>
+
+using namespace RoundsToKill;
+
+namespace
+{
+    // Below this probability of being alive, the enemy is as good as dead.
+    constexpr double aliveThreshold = 1e-12;
+}
+
+int Result::quantile(double probability) const
+{
+    for (int round = 0, size = killedBy.size(); round < size; ++round) {
+        if (killedBy.at(round) >= probability - aliveThreshold)
+            return round + 1;
+    }
+    return -1;
+}
+
+Result RoundsToKill::calculate(const Distribution& roundDamage, const Distribution& hitPoints,
+                               int maximumRounds)
+{
+    return calculate(QVector<Distribution>{roundDamage}, hitPoints, maximumRounds);
+}
+
+Result RoundsToKill::calculate(const Distribution& roundDamage, int hitPoints, int maximumRounds)
+{
+    return calculate(roundDamage, Distribution(hitPoints, {1.0}), maximumRounds);
+}
+
+Result RoundsToKill::calculate(const QVector<Distribution>& cycle, const Distribution& hitPoints,
+                               int maximumRounds)
+{
+    Q_ASSERT(!cycle.isEmpty());
+    Q_ASSERT(hitPoints.first() >= 1);
+    Q_ASSERT(maximumRounds >= 1);
+    const auto& kernels = DistributionKernels::native();
+
+    // The alive states: damage from 0 to the highest hit points minus one.
+    // survival[s] is the probability that the enemy is alive with damage s.
+    const int states = hitPoints.last();
+    const CumulativeDistribution cumulativeHitPoints(hitPoints);
+    QVector<double> survival(states);
+    for (int state = 0; state < states; ++state)
+        survival[state] = cumulativeHitPoints.probabilityAtLeast(state + 1);
+
+    // Negative damage (from penalties) doesn't heal, it's just no damage.
+    QVector<Distribution> rounds;
+    for (const Distribution& damage : cycle) {
+        rounds.append(damage.first() >= 0 ? damage
+                      : damage.mapped([](int value) { return qMax(0, value); }));
+    }
+
+    // Adds to \a next the probabilities of \a current after the damage, except
+    // the part that goes over the cap (that's dead for any hit points).
+    auto advance = [&](const QVector<double>& current, const Distribution& damage,
+                       QVector<double>& next)
+    {
+        const int first = damage.first();
+        const double* probabilities = damage.probabilities().constData();
+        for (int state = 0; state < states; ++state) {
+            const int count = qMin(damage.size(), states - state - first);
+            if (current.at(state) > 0.0 && count > 0)
+                kernels.accumulate(next.data() + state + first, probabilities, count, current.at(state));
+        }
+    };
+
+    Result result;
+
+    // A whole cycle is one step of an homogeneous chain. Its expected visits
+    // to each state from the first one are the row of the fundamental matrix:
+    // n(s) = [s == 0] + sum of D(d) n(s-d), solved for the d = 0 term, and
+    // pushed forward to the next states as it's known.
+    Distribution step;
+    for (const Distribution& damage : rounds)
+        step = step.convolved(damage);
+    const double stay = step.probability(0);
+    if (stay >= 1.0) {
+        result.mean = qInf();
+    } else {
+        // The rounds alive within a cycle that starts at each state: weight[s]
+        // is the sum over the rounds j of the cycle of the probability of being
+        // alive after the first j rounds (the 0th is just being alive at s).
+        QVector<double> weight(states, 0.0);
+        Distribution prefix;
+        for (const Distribution& damage : rounds) {
+            for (int index = 0, size = prefix.size(); index < size; ++index) {
+                const int value = prefix.first() + index;
+                if (value < states) {
+                    kernels.accumulate(weight.data(), survival.constData() + value,
+                                       states - value, prefix.probabilities().at(index));
+                }
+            }
+            prefix = prefix.convolved(damage);
+        }
+
+        const int first = step.first();
+        const int size = qMax(0, qMin(step.size(), states - first));
+        const double* probabilities = step.probabilities().constData();
+        const int skip = first == 0 ? 1 : 0; // The d = 0 term is already solved.
+        QVector<double> visits(states, 0.0);
+        visits[0] = 1.0;
+        for (int state = 0; state < states; ++state) {
+            visits[state] /= 1.0 - stay;
+            const int from = state + first + skip;
+            const int count = qMin(size - skip, states - from);
+            if (count > 0)
+                kernels.accumulate(visits.data() + from, probabilities + skip, count, visits.at(state));
+            result.mean += visits.at(state) * weight.at(state);
+        }
+    }
+
+    // And round by round for the distribution, with the probability of each
+    // alive state, which is what is left after the damage of each round.
+    QVector<double> current(states, 0.0);
+    current[0] = 1.0;
+    for (int round = 0; round < maximumRounds; ++round) {
+        QVector<double> next(states, 0.0);
+        advance(current, rounds.at(round % rounds.size()), next);
+        current = next;
+
+        double alive = 0.0;
+        for (int state = 0; state < states; ++state)
+            alive += current.at(state) * survival.at(state);
+        result.killedBy.append(1.0 - alive);
+        if (alive < aliveThreshold)
+            break;
+    }
+    return result;
+}
@@ -0,0 +1,62 @@
+/*
+ * This file is part of Moebius Toolkit.
+ * Copyright (C) 2026 Alejandro Exojo Piqueras
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QVector>
+
+class Distribution;
+
+/*!
+ * How many rounds it takes to kill an enemy, as an absorbing Markov chain.
+ *
+ * The state is the damage done so far, and each round adds the damage of one
+ * round (e.g. from Damage::roundDistribution()). The enemy is dead once the
+ * damage reaches its hit points, which can be a distribution too (like the
+ * one of the hit dice of a creature, DiceRoll::distribution() of 10d8+20), so
+ * the states go only up to the highest hit points, and any damage beyond that
+ * is the same absorbing state. Damage never goes down, so the chain is
+ * triangular: the expected number of rounds comes from the fundamental matrix
+ * by forward substitution, without iterating round by round.
+ */
+namespace RoundsToKill
+{
+
+struct Result
+{
+    /// Probability of the enemy being dead at the end of each round (index 0
+    /// is the first round). It stops when it's certain, or at the maximum.
+    QVector<double> killedBy;
+    /// Expected number of rounds, exact (not limited by the maximum rounds).
+    /// Infinite if the enemy might never die (no round can do any damage).
+    double mean = 0.0;
+
+    /// The first round at which the enemy is dead with at least
+    /// \a probability (0.5 gives the median), or -1 if not within killedBy.
+    int quantile(double probability) const;
+};
+
+Result calculate(const Distribution& roundDamage, const Distribution& hitPoints,
+                 int maximumRounds = 100);
+Result calculate(const Distribution& roundDamage, int hitPoints, int maximumRounds = 100);
+/// With rounds that are not all the same, but repeat in a \a cycle (like the
+/// ones with different number of attacks, from Damage::roundCycle()).
+Result calculate(const QVector<Distribution>& cycle, const Distribution& hitPoints,
+                 int maximumRounds = 100);
+
+}
@@ -0,0 +1,268 @@
+/*
+ * This file is part of Moebius Toolkit.
+ * Copyright (C) 2026 Alejandro Exojo Piqueras
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "weaponoptimizer.h"
+
+#include <QThread>
+
+#ifndef Q_OS_WASM
+#include <QAtomicInt>
+#include <QThreadPool>
+#endif
+
+#include <algorithm>
+#include <numeric>
+
+using namespace WeaponOptimizer;
+using namespace Calculators;
+
+namespace
+{
+    struct Hand
+    {
+        QVector<WeaponArrangement> weapons;
+        QVector<double> bounds;
+        QVector<double> damages;
+        QVector<bool> evaluated;
+        // The indexes of the candidates, from the best bound to the worst.
+        QVector<int> order;
+
+        double bestBound() const { return order.isEmpty() ? 0.0 : bounds.at(order.first()); }
+    };
+
+    // The candidate with the resistances of the problem applied to its rolls.
+    WeaponArrangement resisted(WeaponArrangement weapon, const Problem& problem)
+    {
+        for (auto entry = weapon.damage.begin(), last = weapon.damage.end(); entry != last; ++entry)
+            entry.value().resistance(problem.resistances.value(entry.key(), 0.0));
+        return weapon;
+    }
+
+    // The damage per round of a weapon in the main hand, given the hits.
+    double damagePerRound(const WeaponArrangement& weapon, QPair<int, int> hits,
+                          double regular, double critical)
+    {
+        const double attacks = RoundSchedule::of(weapon.attacks).average();
+        return attacks * (hits.first * regular + hits.second * critical) / 20;
+    }
+
+    // The highest damage of the rolls, which is never lower than the average.
+    // The resistance and probability can only make it lower, so they are
+    // ignored.
+    double upperBound(const WeaponArrangement& weapon, const Problem& problem)
+    {
+        const Damage damage(weapon, weapon, problem.common);
+        double physical = 0.0;
+        double elemental = 0.0;
+        for (auto entry = weapon.damage.constBegin(), last = weapon.damage.constEnd();
+             entry != last; ++entry)
+        {
+            if (entry.key() & DamageType::ElementalBit) {
+                elemental += qMax(0, entry.value().maximum());
+            } else {
+                DiceRoll roll = weapon.physicalDamage();
+                roll.bonus(roll.bonus() + problem.common.damageBonuses());
+                physical += qMax(0, roll.maximum());
+            }
+        }
+        const double regular = physical + elemental;
+        const double critical = (problem.critical == Damage::Critical ? 2 : 1) * physical + elemental;
+        const auto hits = damage.hitTable(Damage::One, problem.ac, problem.ac).constFirst();
+        return damagePerRound(weapon, hits, regular, critical);
+    }
+
+    double exactDamage(const WeaponArrangement& weapon, const Problem& problem)
+    {
+        const Damage damage(weapon, weapon, problem.common);
+        const auto hits = damage.hitTable(Damage::One, problem.ac, problem.ac).constFirst();
+        return damagePerRound(weapon, hits, damage.onHitDamage(Damage::One, Damage::Regular),
+                              damage.onHitDamage(Damage::One, problem.critical));
+    }
+
+    Hand prepare(const QVector<WeaponArrangement>& candidates, const Problem& problem)
+    {
+        Hand hand;
+        hand.weapons.reserve(candidates.size());
+        for (const WeaponArrangement& weapon : candidates) {
+            hand.weapons.append(resisted(weapon, problem));
+            hand.bounds.append(upperBound(hand.weapons.constLast(), problem));
+        }
+        hand.damages.fill(0.0, candidates.size());
+        hand.evaluated.fill(false, candidates.size());
+        hand.order.resize(candidates.size());
+        std::iota(hand.order.begin(), hand.order.end(), 0);
+        std::stable_sort(hand.order.begin(), hand.order.end(), [&hand](int a, int b) {
+            return hand.bounds.at(a) > hand.bounds.at(b);
+        });
+        return hand;
+    }
+
+    template <typename Function>
+    void parallelFor(int count, int threads, Function function)
+    {
+#ifndef Q_OS_WASM
+        threads = qMin(threads > 0 ? threads : QThread::idealThreadCount(), count);
+        if (threads > 1) {
+            QAtomicInt next = 0;
+            QThreadPool pool;
+            pool.setMaxThreadCount(threads);
+            for (int thread = 0; thread < threads; ++thread) {
+                pool.start([&] {
+                    for (int index = next.fetchAndAddRelaxed(1); index < count;
+                         index = next.fetchAndAddRelaxed(1))
+                    {
+                        function(index);
+                    }
+                });
+            }
+            pool.waitForDone();
+            return;
+        }
+#else
+        Q_UNUSED(threads)
+#endif
+        for (int index = 0; index < count; ++index)
+            function(index);
+    }
+
+    // Keeps the best \a count configurations seen, from the most damage to the
+    // least (and by index on ties, so the result doesn't depend on the order).
+    class Top
+    {
+    public:
+        explicit Top(int count) : m_count(count) {}
+
+        bool full() const { return m_best.size() >= m_count; }
+        // The damage to beat to get in.
+        double threshold() const { return full() ? m_best.constLast().damage : -qInf(); }
+
+        void add(const Configuration& configuration)
+        {
+            const int position = int(std::upper_bound(m_best.begin(), m_best.end(),
+                                                      configuration, better) - m_best.begin());
+            if (position >= m_count)
+                return;
+            m_best.insert(position, configuration);
+            if (m_best.size() > m_count)
+                m_best.removeLast();
+        }
+
+        const QVector<Configuration>& best() const { return m_best; }
+
+    private:
+        static bool better(const Configuration& a, const Configuration& b)
+        {
+            if (a.damage != b.damage)
+                return a.damage > b.damage;
+            return std::make_pair(a.mainHand, a.offHand) < std::make_pair(b.mainHand, b.offHand);
+        }
+
+        int m_count;
+        QVector<Configuration> m_best;
+    };
+}
+
+Result WeaponOptimizer::optimize(const Problem& problem, const Options& options)
+{
+    Q_ASSERT(problem.count > 0);
+    Q_ASSERT(!problem.sameItems || problem.mainHand.size() == problem.offHand.size());
+    Hand main = prepare(problem.mainHand, problem);
+    Hand off = prepare(problem.offHand, problem);
+    const bool dualWielding = !off.weapons.isEmpty();
+    auto valid = [&](int one, int two) { return !problem.sameItems || one != two; };
+
+    Result result;
+    auto evaluate = [&](Hand& hand, const QVector<int>& candidates) {
+        parallelFor(candidates.size(), options.threads, [&](int index) {
+            const int candidate = candidates.at(index);
+            hand.damages[candidate] = exactDamage(hand.weapons.at(candidate), problem);
+        });
+        for (int candidate : candidates)
+            hand.evaluated[candidate] = true;
+        result.evaluated += candidates.size();
+    };
+
+    // The best few by bound give a first threshold, which the exact damage of
+    // the pairs of the best candidates is likely to be close to.
+    const int seeds = problem.count + (problem.sameItems ? 1 : 0);
+    evaluate(main, main.order.mid(0, seeds));
+    evaluate(off, off.order.mid(0, seeds));
+    Top seed(problem.count);
+    for (int one : main.order.mid(0, seeds)) {
+        if (!dualWielding)
+            seed.add({one, -1, main.damages.at(one)});
+        for (int two : off.order.mid(0, seeds)) {
+            if (valid(one, two))
+                seed.add({one, two, main.damages.at(one) + off.damages.at(two)});
+        }
+    }
+
+    // Only the candidates that could make it into the top with the best
+    // possible partner survive.
+    auto survivors = [&](const Hand& hand, double partnerBound) {
+        QVector<int> candidates;
+        for (int candidate : hand.order) {
+            if (hand.bounds.at(candidate) + partnerBound < seed.threshold())
+                break;
+            if (!hand.evaluated.at(candidate))
+                candidates.append(candidate);
+        }
+        return candidates;
+    };
+    const QVector<int> mainSurvivors = survivors(main, off.bestBound());
+    const QVector<int> offSurvivors = survivors(off, main.bestBound());
+    evaluate(main, mainSurvivors);
+    evaluate(off, offSurvivors);
+
+    // All the evaluated ones, by damage, and the pairs best first: once even
+    // the best partner can't get a pair in, the following ones can't either.
+    auto ranked = [](const Hand& hand) {
+        QVector<int> candidates;
+        for (int candidate : hand.order) {
+            if (hand.evaluated.at(candidate))
+                candidates.append(candidate);
+        }
+        std::stable_sort(candidates.begin(), candidates.end(), [&hand](int a, int b) {
+            return hand.damages.at(a) > hand.damages.at(b);
+        });
+        return candidates;
+    };
+    const QVector<int> mainRanked = ranked(main);
+    const QVector<int> offRanked = ranked(off);
+    Top top(problem.count);
+    for (int one : mainRanked) {
+        const double damage = main.damages.at(one);
+        if (!dualWielding) {
+            if (damage < top.threshold())
+                break;
+            top.add({one, -1, damage});
+            continue;
+        }
+        if (offRanked.isEmpty() || damage + off.damages.at(offRanked.first()) < top.threshold())
+            break;
+        for (int two : offRanked) {
+            if (damage + off.damages.at(two) < top.threshold())
+                break;
+            if (valid(one, two))
+                top.add({one, two, damage + off.damages.at(two)});
+        }
+    }
+
+    result.best = top.best();
+    return result;
+}
@@ -0,0 +1,87 @@
+/*
+ * This file is part of Moebius Toolkit.
+ * Copyright (C) 2026 Alejandro Exojo Piqueras
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QVector>
+
+#include "calculators.h"
+
+/*!
+ * The best pairs of weapons for the main and off hand, from lists of
+ * candidates, by average damage per round against one armor class and set of
+ * resistances.
+ *
+ * The damage of each hand only depends on its own weapon, so the damage of a
+ * pair is the sum of both. First an upper bound of each candidate comes from
+ * the maximum of its rolls and the hits from the table, which is cheap. The
+ * best few by bound give the K-th best damage so far, and any candidate whose
+ * bound, plus the best bound of the other hand, can't reach it is discarded
+ * without calculating its damage. The rest are evaluated in parallel, and the
+ * pairs are taken best first, stopping once none can get into the top.
+ */
+namespace WeaponOptimizer
+{
+
+struct Problem
+{
+    /// The candidates of each hand, with the modifiers of that hand already
+    /// applied (e.g. the penalties to hit of fighting with two weapons). With
+    /// no off hand candidates, only the main hand is used.
+    QVector<Calculators::WeaponArrangement> mainHand;
+    QVector<Calculators::WeaponArrangement> offHand;
+    /// The off hand candidates are the same items as the main hand ones, in
+    /// the same order, so a pair can't use the same index in both hands.
+    bool sameItems = false;
+
+    Calculators::Damage::Common common;
+    int ac = 0;
+    /// Applied to the damage of that type of every candidate.
+    Calculators::DamageMap<double> resistances;
+    /// What a critical hit does to the damage (helmets prevent the doubling).
+    Calculators::Damage::Stat critical = Calculators::Damage::Critical;
+    /// How many of the best pairs to return.
+    int count = 10;
+};
+
+struct Configuration
+{
+    int mainHand = -1;
+    /// -1 if there is no off hand weapon.
+    int offHand = -1;
+    /// Average damage per round.
+    double damage = 0.0;
+};
+
+struct Result
+{
+    /// The best ones, from the most damage to the least.
+    QVector<Configuration> best;
+    /// How many candidates needed the damage calculated (the rest were pruned).
+    int evaluated = 0;
+};
+
+struct Options
+{
+    /// 0 uses as many threads as cores.
+    int threads = 0;
+};
+
+Result optimize(const Problem& problem, const Options& options = {});
+
+}
@@ -1,10 +1,18 @@
 TEMPLATE = subdirs
 SUBDIRS += \
+    backstabstats \
     bifffile \
     calculators \
+    damageexpression \
+    damagegraph \
+    damagesweep \
     diceroll \
+    distribution \
     keyfile \
+    montecarlo \
     resourcemanager \
+    roundstokill \
     tdafile \
     tlkfile \
+    weaponoptimizer \
     xplevels \
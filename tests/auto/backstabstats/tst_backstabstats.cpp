@@ -0,0 +1,147 @@
+/*
+ * This file is part of Moebius Toolkit.
+ * Copyright (C) 2026 Alejandro Exojo Piqueras
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <QtTest>
+
+#include "backstabstats.h"
+#include "calculators.h"
+#include "diceroll.h"
+
+#include <numeric>
+
+using namespace Calculators;
+
+class tst_BackstabStats : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void coin();
+    void maximumDamage();
+    void luckAndElemental();
+    void pageAverages();
+};
+
+// Small enough to calculate by hand: 1 or 2 times 3, plus the kit bonus twice.
+void tst_BackstabStats::coin()
+{
+    WeaponArrangement weapon;
+    weapon.damage.insert(DamageType::Piercing, DiceRoll().sides(2));
+    Backstab::Other other;
+    other.multiplier = 3;
+    other.kit = 1;
+    other.strength = 2;
+
+    const BackstabResult result = calculateBackstab(Backstab(weapon, other));
+    QCOMPARE(result.distribution, Distribution(7, {0.5, 0.0, 0.0, 0.5}));
+    QCOMPARE(result.minimum, 7);
+    QCOMPARE(result.maximum, 10);
+    QCOMPARE(result.mean, 8.5);
+    QCOMPARE(result.multipliedMean, 2.5);
+    QCOMPARE(result.percentile(0.5), 7);
+    QCOMPARE(result.percentile(0.9), 10);
+    QCOMPARE(result.killChance(7), 1.0);
+    QCOMPARE(result.killChance(8), 0.5);
+    QCOMPARE(result.killChance(11), 0.0);
+}
+
+void tst_BackstabStats::maximumDamage()
+{
+    WeaponArrangement weapon;
+    weapon.damage.insert(DamageType::Slashing, DiceRoll().sides(8).bonus(2));
+    weapon.damage.insert(DamageType::Cold, DiceRoll().sides(6));
+    weapon.proficiencyDamage = 1;
+    Backstab::Other other;
+    other.multiplier = 5;
+    other.bonus = 2;
+    other.strength = 4;
+    other.maximumDamage = true;
+
+    // (8 + 2 + 1) * 5, the other bonus 4 times, 6 of cold and 4 of strength.
+    const BackstabResult result = calculateBackstab(Backstab(weapon, other));
+    QCOMPARE(result.minimum, 73);
+    QCOMPARE(result.maximum, 73);
+    QCOMPARE(result.percentile(0.1), 73);
+}
+
+// The averages from the ones of the dice, as luck only applies to the physical
+// damage, and the elemental damage is not multiplied.
+void tst_BackstabStats::luckAndElemental()
+{
+    const DiceRoll physical = DiceRoll().sides(6).bonus(1);
+    const DiceRoll fire = DiceRoll().number(2).sides(4);
+    WeaponArrangement weapon;
+    weapon.damage.insert(DamageType::Piercing, physical);
+    weapon.damage.insert(DamageType::Fire, fire);
+    Backstab::Other other;
+    other.multiplier = 4;
+    other.kit = 2;
+    other.luck = 2;
+
+    const BackstabResult result = calculateBackstab(Backstab(weapon, other));
+    const double lucky = DiceRoll(physical).luck(2).average();
+    QVERIFY(qAbs(result.multipliedMean - (lucky + other.kit)) < 1e-9);
+    QVERIFY(qAbs(result.mean - (4 * lucky + 3 * other.kit + fire.average())) < 1e-9);
+    // 4 to 7 of the luckified d6+1 times 4, the kit 3 times, plus 2 to 8 of fire.
+    QCOMPARE(result.minimum, 4 * 4 + 3 * 2 + 2);
+    QCOMPARE(result.maximum, 4 * 7 + 3 * 2 + 8);
+    const auto& probabilities = result.distribution.probabilities();
+    QVERIFY(qAbs(std::accumulate(probabilities.begin(), probabilities.end(), 0.0) - 1.0) < 1e-9);
+    QVERIFY(result.percentile(0.1) <= result.percentile(0.5));
+    QVERIFY(result.percentile(0.5) <= result.percentile(0.9));
+}
+
+// Against the averages that the backstab page calculated before it used the
+// distribution: the weapon damage once, then the physical damage plus the kit
+// and other bonuses (multiplier - 1) times, and the strength bonus. The only
+// difference is that the page left the proficiency damage out of the base hit,
+// while physicalDamage() has it in all the hits.
+void tst_BackstabStats::pageAverages()
+{
+    WeaponArrangement weapon;
+    weapon.damage.insert(DamageType::Slashing, DiceRoll().sides(10).bonus(3));
+    weapon.damage.insert(DamageType::Acid, DiceRoll().number(2).sides(6));
+    weapon.proficiencyDamage = 2;
+
+    for (int multiplier = 2; multiplier <= 7; ++multiplier) {
+        for (int kit = 0; kit <= 3; ++kit) {
+            Backstab::Other other;
+            other.multiplier = multiplier;
+            other.kit = kit;
+            other.bonus = 2;
+            other.strength = 6;
+
+            double weaponDamage = 0.0;
+            for (const auto& damage : weapon.damage)
+                weaponDamage += damage.average();
+            weaponDamage += weapon.proficiencyDamage; // Missing in the page.
+            const double physicalPart = weapon.physicalDamage().average() + kit + other.bonus;
+            const double expected = other.strength + weaponDamage
+                                  + (multiplier - 1) * physicalPart;
+
+            const BackstabResult result = calculateBackstab(Backstab(weapon, other));
+            QVERIFY(qAbs(result.mean - expected) < 1e-9);
+            QVERIFY(qAbs(result.multipliedMean - physicalPart) < 1e-9);
+        }
+    }
+}
+
+QTEST_MAIN(tst_BackstabStats)
+
+#include "tst_backstabstats.moc"
@@ -20,6 +20,8 @@
 
 #include "calculators.h"
 
+#include <numeric>
+
 using namespace Calculators;
 
 class tst_Calculators : public QObject
@@ -31,6 +33,11 @@ private slots:
     void testHitRatio();
     void testDamage_data();
     void testDamage();
+    void hitTable();
+    void roundDistribution();
+    void roundSchedule();
+    void averageDamages_data();
+    void averageDamages();
 private:
     WeaponArrangement defaultWeapon() // Quarterstaff at Wintrhop's
     {
@@ -195,7 +202,7 @@ void tst_Calculators::testDamage_data()
             << 12.5 << 0.0;
 
     WeaponArrangement weapon = defaultWeapon();
-    weapon.damage.find(DamageType::Crushing).value().resistance(0.5);
+    weapon.damage[DamageType::Crushing].resistance(0.5);
     QTest::addRow("19 STR with +2 bonus at 50%% resistance")
             << common << weapon << weapon
             << 6.5 << 0.0;
@@ -205,12 +212,12 @@ void tst_Calculators::testDamage_data()
             << common << weapon << weapon
             << 14.5 << 1.0;
 
-    weapon.damage.find(DamageType::Electricity).value().resistance(0.75);
+    weapon.damage[DamageType::Electricity].resistance(0.75);
     QTest::addRow("Ashideena, 19 STR with +2 bonus, 75%% resistance to element")
             << common << weapon << weapon
             << 14.5 << 1.0;
 
-    weapon.damage.find(DamageType::Electricity).value().resistance(1.0);
+    weapon.damage[DamageType::Electricity].resistance(1.0);
     QTest::addRow("Ashideena, 19 STR with +2 bonus, 100%% resistance to element")
             << common << weapon << weapon
             << 14.5 << 0.0;
@@ -223,8 +230,8 @@ void tst_Calculators::testDamage_data()
             << common << weapon << weapon
             << 10.5 << 1.0;
 
-    weapon.damage.find(DamageType::Slashing).value().resistance(0.5);
-    weapon.damage.find(DamageType::Cold).value().resistance(1.0);
+    weapon.damage[DamageType::Slashing].resistance(0.5);
+    weapon.damage[DamageType::Cold].resistance(1.0);
     QTest::addRow("Varscona, 17 STR, mastery, 50%% slashing, 100%% cold")
             << common << weapon << weapon
             << 5.5 << 0.0;
@@ -244,15 +251,226 @@ void tst_Calculators::testDamage()
     QCOMPARE(averageDamages.value(weapon1.physicalDamageType()), physical);
 
     // No "find_if" for associative containers. Just loop over it.
-    QHash<DamageType, double>::const_key_value_iterator result = averageDamages.keyValueBegin();
-    for (; result != averageDamages.keyValueEnd(); ++result) {
-        if (result.base().key() & DamageType::ElementalBit) {
-            QCOMPARE(result.base().value(), elemental);
+    DamageMap<double>::const_iterator result = averageDamages.constBegin();
+    for (; result != averageDamages.constEnd(); ++result) {
+        if (result.key() & DamageType::ElementalBit) {
+            QCOMPARE(result.value(), elemental);
             break;
         }
     }
 }
 
+// The table, against the rolls looped one by one by hitDistribution().
+void tst_Calculators::hitTable()
+{
+    for (int criticalHit : {0, 5, 10, 20, 105}) {
+        for (int criticalMiss : {0, 5, 10, 25}) {
+            for (int thac0 : {20, 11, 0, -5}) {
+                WeaponArrangement weapon = defaultWeapon();
+                weapon.criticalHit = criticalHit;
+                weapon.criticalMiss = criticalMiss;
+                weapon.weaponToHit = 3;
+                Damage::Common common;
+                common.thac0 = thac0;
+                const Damage damage(weapon, defaultWeapon(), common);
+
+                const auto ascending = damage.hitTable(Damage::One, -30, 30);
+                const auto descending = damage.hitTable(Damage::One, 30, -30);
+                QCOMPARE(ascending.size(), 61);
+                QCOMPARE(descending.size(), 61);
+                for (int ac = -30; ac <= 30; ++ac) {
+                    const auto expected = damage.hitDistribution(Damage::One, ac);
+                    QCOMPARE(ascending.at(ac + 30), expected);
+                    QCOMPARE(descending.at(30 - ac), expected);
+                }
+            }
+        }
+    }
+    const Damage damage(defaultWeapon(), defaultWeapon(), Damage::Common());
+    // THAC0 20 against AC 4: hits with 16 to 19, and critical with 20.
+    const QVector<QPair<int, int>> single = {{4, 1}};
+    QCOMPARE(damage.hitTable(Damage::Two, 4, 4), single);
+}
+
+// One small case calculated by hand, and then the averages of the whole range
+// of armor classes, against the formula of the averages that the damage
+// calculator uses.
+void tst_Calculators::roundDistribution()
+{
+    WeaponArrangement coin;
+    coin.damage.insert(DamageType::Crushing, DiceRoll().sides(2));
+    const Damage::Common common; // THAC0 20: hits AC 9 with 11 or more.
+    const Damage damage(coin, coin, common);
+
+    // Miss with 1-10, regular hit with 11-19 and critical with 20.
+    const Distribution attack = damage.attackDistribution(Damage::One, 9);
+    QCOMPARE(attack, Distribution(0, {0.5, 0.225, 0.25, 0.0, 0.025}));
+    QCOMPARE(damage.attackDistribution(Damage::One, 9, Damage::Regular),
+             Distribution(0, {0.5, 0.25, 0.25}));
+    QCOMPARE(damage.roundDistribution(Damage::One, 9), attack);
+    QCOMPARE(damage.roundDistribution(9, 9), attack.convolved(attack));
+
+    WeaponArrangement weapon1 = varscona();
+    weapon1.attacks = 2.5;
+    weapon1.criticalHit = 10;
+    weapon1.damage[DamageType::Slashing].resistance(0.3);
+    WeaponArrangement weapon2 = ashideena();
+    weapon2.attacks = 1.0;
+    weapon2.styleToHit = -4;
+    Damage::Common strong;
+    strong.thac0 = 8;
+    strong.statToHit = 3;
+    strong.statDamage = 7;
+    const Damage calculator(weapon1, weapon2, strong);
+
+    // Two or three attacks, one round each, against the distribution of one
+    // attack added two and three times.
+    const Distribution attack1 = calculator.attackDistribution(Damage::One, -3);
+    const Distribution reference = attack1.power(2).mixed(0.5, attack1.power(3));
+    const Distribution round1 = calculator.roundDistribution(Damage::One, -3);
+    QCOMPARE(round1.first(), reference.first());
+    QCOMPARE(round1.size(), reference.size());
+    for (int value = reference.first(); value <= reference.last(); ++value)
+        QVERIFY(qAbs(round1.probability(value) - reference.probability(value)) < 1e-12);
+    QCOMPARE(calculator.roundDistributions(Damage::One, {5, -3, 2}).at(1), round1);
+
+    const double regular1 = calculator.onHitDamage(Damage::One, Damage::Regular);
+    const double critical1 = calculator.onHitDamage(Damage::One, Damage::Critical);
+    const double regular2 = calculator.onHitDamage(Damage::Two, Damage::Regular);
+    const double critical2 = calculator.onHitDamage(Damage::Two, Damage::Critical);
+    for (int ac = 10; ac >= -20; --ac) {
+        const auto hits1 = calculator.hitDistribution(Damage::One, ac);
+        const auto hits2 = calculator.hitDistribution(Damage::Two, ac + 2);
+        const double expected = weapon1.attacks * (hits1.first * regular1 + hits1.second * critical1) / 20
+                              + weapon2.attacks * (hits2.first * regular2 + hits2.second * critical2) / 20;
+        const Distribution round = calculator.roundDistribution(ac, ac + 2);
+        QVERIFY(qAbs(round.mean() - expected) < 1e-9);
+        const auto& probabilities = round.probabilities();
+        QVERIFY(qAbs(std::accumulate(probabilities.begin(), probabilities.end(), 0.0) - 1.0) < 1e-9);
+    }
+}
+
+void tst_Calculators::roundSchedule()
+{
+    const RoundSchedule oneAndHalf = RoundSchedule::of(1.5);
+    QCOMPARE(oneAndHalf.period(), 2);
+    QCOMPARE(oneAndHalf.attacks(0), 1);
+    QCOMPARE(oneAndHalf.attacks(1), 2);
+    QCOMPARE(oneAndHalf.attacks(2), 1);
+    QCOMPARE(oneAndHalf.totalAttacks(3), 4);
+    QCOMPARE(RoundSchedule::of(3.0).period(), 1);
+    QCOMPARE(RoundSchedule::of(3.0).totalAttacks(5), 15);
+
+    // Not in the tables: 1, 1, 1 and 2 attacks.
+    const RoundSchedule quarter = RoundSchedule::of(1.25);
+    QCOMPARE(quarter.period(), 4);
+    QCOMPARE(quarter.attacks(3), 2);
+    QCOMPARE(quarter.average(), 1.25);
+    QCOMPARE(RoundSchedule::of(4.0 / 3).period(), 3);
+
+    for (int halves = 0; halves <= 20; ++halves) {
+        const RoundSchedule schedule = RoundSchedule::of(halves / 2.0);
+        QCOMPARE(schedule.average(), halves / 2.0);
+        QCOMPARE(schedule.totalAttacks(10), halves * 5);
+    }
+
+    WeaponArrangement weapon1 = varscona();
+    weapon1.attacks = 1.5;
+    WeaponArrangement weapon2 = defaultWeapon();
+    weapon2.attacks = 1.0;
+    const Damage calculator(weapon1, weapon2, Damage::Common());
+    const Distribution attack1 = calculator.attackDistribution(Damage::One, 2);
+    const Distribution attack2 = calculator.attackDistribution(Damage::Two, 4);
+
+    const QVector<Distribution> cycle1 = calculator.roundCycle(Damage::One, 2);
+    QCOMPARE(cycle1.size(), 2);
+    QCOMPARE(cycle1.at(0), attack1);
+    QCOMPARE(cycle1.at(1), attack1.convolved(attack1));
+    const QVector<Distribution> cycle = calculator.roundCycle(2, 4);
+    QCOMPARE(cycle.size(), 2);
+    QCOMPARE(cycle.at(1), cycle1.at(1).convolved(attack2));
+
+    // Three rounds are four attacks, and on average it's the same damage.
+    const Distribution rounds = calculator.roundsDistribution(Damage::One, 2, 3);
+    QCOMPARE(rounds, attack1.power(4));
+    QVERIFY(qAbs(calculator.roundsDistribution(Damage::One, 2, 2).mean()
+                 - 2 * calculator.roundDistribution(Damage::One, 2).mean()) < 1e-9);
+}
+
+void tst_Calculators::averageDamages_data()
+{
+    QTest::addColumn<bool>("offHand");
+    QTest::addColumn<bool>("doubleCriticalDamage");
+    QTest::addColumn<bool>("criticalStrike");
+    QTest::addColumn<bool>("maximumDamage");
+
+    for (int flags = 0; flags < 16; ++flags) {
+        const bool offHand = flags & 1, doubleCriticalDamage = flags & 2,
+                   criticalStrike = flags & 4, maximumDamage = flags & 8;
+        QTest::addRow("off hand %d, double critical %d, critical strike %d, maximum %d",
+                      offHand, doubleCriticalDamage, criticalStrike, maximumDamage)
+                << offHand << doubleCriticalDamage << criticalStrike << maximumDamage;
+    }
+}
+
+// Against the arrangements changed as the switches say, and the hits counted
+// for each armor class with hitDistribution().
+void tst_Calculators::averageDamages()
+{
+    QFETCH(bool, offHand);
+    QFETCH(bool, doubleCriticalDamage);
+    QFETCH(bool, criticalStrike);
+    QFETCH(bool, maximumDamage);
+
+    WeaponArrangement weapon1 = varscona();
+    weapon1.attacks = 2.5;
+    weapon1.criticalHit = 10;
+    weapon1.damage[DamageType::Slashing].luck(1).resistance(0.3);
+    WeaponArrangement weapon2 = ashideena();
+    weapon2.attacks = 1.0;
+    weapon2.styleToHit = -4;
+    Damage::Common common;
+    common.thac0 = 8;
+    common.statToHit = 3;
+    common.statDamage = 7;
+
+    Damage::Sweep sweep;
+    sweep.acFrom = 10;
+    sweep.acTo = -20;
+    sweep.acModifier1 = 0;
+    sweep.acModifier2 = -2;
+    sweep.offHand = offHand;
+    sweep.doubleCriticalDamage = doubleCriticalDamage;
+    sweep.criticalStrike = criticalStrike;
+    sweep.maximumDamage = maximumDamage;
+    const QVector<double> damages = Damage(weapon1, weapon2, common).averageDamages(sweep);
+
+    for (WeaponArrangement* weapon : {&weapon1, &weapon2}) {
+        if (criticalStrike)
+            weapon->criticalHit = 100;
+        DiceRoll& roll = weapon->damage[weapon->physicalDamageType()];
+        roll.luck(roll.luck() + (maximumDamage ? 20 : 0));
+    }
+    const Damage calculator(weapon1, weapon2, common);
+    const Damage::Stat critical = doubleCriticalDamage ? Damage::Critical : Damage::Regular;
+    const double regular1 = calculator.onHitDamage(Damage::One, Damage::Regular);
+    const double critical1 = calculator.onHitDamage(Damage::One, critical);
+    const double regular2 = calculator.onHitDamage(Damage::Two, Damage::Regular);
+    const double critical2 = calculator.onHitDamage(Damage::Two, critical);
+    if (maximumDamage) // 8 of the d8, +2 +7 with 30% resisted, plus 1 of cold.
+        QCOMPARE(regular1, 13.0);
+
+    QCOMPARE(damages.size(), 31);
+    for (int ac = 10; ac >= -20; --ac) {
+        const auto hits1 = calculator.hitDistribution(Damage::One, ac);
+        const auto hits2 = calculator.hitDistribution(Damage::Two, ac + 2);
+        double expected = weapon1.attacks * (hits1.first * regular1 + hits1.second * critical1) / 20;
+        if (offHand)
+            expected += weapon2.attacks * (hits2.first * regular2 + hits2.second * critical2) / 20;
+        QVERIFY(qAbs(damages.at(10 - ac) - expected) < 1e-9);
+    }
+}
+
 QTEST_MAIN(tst_Calculators)
 
 #include "tst_calculators.moc"
@@ -0,0 +1,12 @@
+TEMPLATE = app
+TARGET = tst_damageexpression
+
+QT = core testlib
+CONFIG += testcase no_testcase_installs
+CONFIG -= app_bundle
+
+projectGlobals()
+useLibMoebius()
+
+SOURCES += tst_damageexpression.cpp
+
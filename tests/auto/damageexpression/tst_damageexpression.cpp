@@ -0,0 +1,194 @@
+/*
+ * This file is part of Moebius Toolkit.
+ * Copyright (C) 2026 Alejandro Exojo Piqueras
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtTest>
+
+#include "damageexpression.h"
+
+using namespace Calculators;
+
+class tst_DamageExpression : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void fromString_data();
+    void fromString();
+    void errors_data();
+    void errors();
+    void distribution();
+    void sharedNodes();
+    void fromArrangement();
+    void roundTrip();
+};
+
+void tst_DamageExpression::fromString_data()
+{
+    QTest::addColumn<QString>("text");
+    QTest::addColumn<QString>("normalized");
+    QTest::addColumn<int>("terms");
+    QTest::addColumn<double>("average");
+
+    QTest::newRow("empty") << QString() << QString() << 0 << 0.0;
+    QTest::newRow("dice") << QStringLiteral("1d8") << QStringLiteral("1d8") << 1 << 4.5;
+    QTest::newRow("no number") << QStringLiteral("d6") << QStringLiteral("1d6") << 1 << 3.5;
+    QTest::newRow("constant") << QStringLiteral(" 2 ") << QStringLiteral("2") << 1 << 2.0;
+    QTest::newRow("penalty") << QStringLiteral("1d4-1") << QStringLiteral("1d4-1") << 1 << 1.5;
+    QTest::newRow("example")
+            << QStringLiteral("1d8+3 + 1d6[fire] + 2d4[acid]@25%")
+            << QStringLiteral("1d8+3 + 1d6[fire] + 2d4[acid]@25%") << 3 << 7.5 + 3.5 + 1.25;
+    QTest::newRow("spaces and case")
+            << QStringLiteral("2D6 [ Cold ] @ 50 % +1[magic]")
+            << QStringLiteral("2d6[cold]@50% + 1[magic]") << 2 << 4.5;
+    QTest::newRow("separate bonus")
+            << QStringLiteral("1d8 + 3") << QStringLiteral("1d8 + 3") << 2 << 7.5;
+    QTest::newRow("sum without spaces")
+            << QStringLiteral("1d8+1d6") << QStringLiteral("1d8 + 1d6") << 2 << 8.0;
+    QTest::newRow("bonus and sum without spaces")
+            << QStringLiteral("1d8+2+d6[fire]") << QStringLiteral("1d8+2 + 1d6[fire]") << 2 << 10.0;
+}
+
+void tst_DamageExpression::fromString()
+{
+    QFETCH(QString, text);
+    QFETCH(QString, normalized);
+    QFETCH(int, terms);
+    QFETCH(double, average);
+
+    bool ok = false;
+    const DamageExpression expression = DamageExpression::fromString(text, &ok);
+    QVERIFY(ok);
+    QCOMPARE(expression.terms().size(), terms);
+    QCOMPARE(expression.toString(), normalized);
+    QCOMPARE(expression.average(), average);
+
+    const DamageExpression again = DamageExpression::fromString(expression.toString(), &ok);
+    QVERIFY(ok);
+    QVERIFY(again.terms() == expression.terms());
+}
+
+void tst_DamageExpression::errors_data()
+{
+    QTest::addColumn<QString>("text");
+
+    QTest::newRow("letters") << QStringLiteral("foo");
+    QTest::newRow("no sides") << QStringLiteral("1d");
+    QTest::newRow("zero sides") << QStringLiteral("1d0");
+    QTest::newRow("no term") << QStringLiteral("1d6 +");
+    QTest::newRow("bad type") << QStringLiteral("1d6[wood]");
+    QTest::newRow("open type") << QStringLiteral("1d6[fire");
+    QTest::newRow("no percent") << QStringLiteral("1d6@25");
+    QTest::newRow("too likely") << QStringLiteral("1d6@125%");
+    QTest::newRow("trailing") << QStringLiteral("1d6 2d6");
+    QTest::newRow("subtracted dice") << QStringLiteral("1d8-1d6");
+    QTest::newRow("huge") << QStringLiteral("99999999999d6");
+}
+
+void tst_DamageExpression::errors()
+{
+    QFETCH(QString, text);
+    bool ok = true;
+    const DamageExpression expression = DamageExpression::fromString(text, &ok);
+    QVERIFY(!ok);
+    QVERIFY(expression.terms().isEmpty());
+}
+
+// The same as adding the distributions of each term by hand.
+void tst_DamageExpression::distribution()
+{
+    const DamageExpression expression = DamageExpression::fromString(
+                QStringLiteral("1d8+3 + 1d6[fire] + 2d4[acid]@25%"));
+    const Distribution expected = DiceRoll().sides(8).bonus(3).distribution()
+            .convolved(DiceRoll().sides(6).distribution())
+            .convolved(DiceRoll().number(2).sides(4).probability(0.25).distribution());
+    QCOMPARE(expression.distribution(), expected);
+    QCOMPARE(expression.distribution().mean(), expression.average());
+
+    // Only the typed terms get resisted.
+    const DamageExpression::Resistances resistances = {
+        {DamageType::Fire, 0.5}, {DamageType::Slashing, 0.9}
+    };
+    const Distribution resisted = DiceRoll().sides(8).bonus(3).distribution()
+            .convolved(DiceRoll().sides(6).resistance(0.5).distribution())
+            .convolved(DiceRoll().number(2).sides(4).probability(0.25).distribution());
+    QCOMPARE(expression.distribution(resistances), resisted);
+
+    QCOMPARE(DamageExpression().distribution(), Distribution());
+}
+
+void tst_DamageExpression::sharedNodes()
+{
+    // Two different rolls and their sum.
+    QCOMPARE(DamageExpression::fromString(QStringLiteral("1d8 + 1d6")).graphSize(), 3);
+    // The same 1d6, resisted the same, so one roll, a power and a sum.
+    const auto elements = DamageExpression::fromString(
+                QStringLiteral("1d8 + 1d6[fire] + 1d6[cold]"));
+    QCOMPARE(elements.graphSize(), 4);
+    QCOMPARE(elements.graphSize({{DamageType::Fire, 0.5}}), 5);
+    QCOMPARE(elements.distribution(),
+             DamageExpression::fromString(QStringLiteral("1d8 + 1d6 + 1d6")).distribution());
+    // The mixture reuses the 1d6 that always happens.
+    QCOMPARE(DamageExpression::fromString(QStringLiteral("1d6 + 1d6@50%")).graphSize(), 3);
+}
+
+void tst_DamageExpression::fromArrangement()
+{
+    WeaponArrangement varscona;
+    varscona.damage.insert(DamageType::Slashing, DiceRoll().sides(8).bonus(2));
+    varscona.damage.insert(DamageType::Cold, DiceRoll().number(0).bonus(1));
+    varscona.proficiencyDamage = 2;
+
+    const DamageExpression expression = DamageExpression::fromArrangement(varscona);
+    QCOMPARE(expression.terms().size(), 2);
+    const Damage damage(varscona, varscona, Damage::Common());
+    QCOMPARE(expression.average(), damage.onHitDamage(Damage::One, Damage::Regular));
+    QCOMPARE(expression.distribution().first(), 1 + 4 + 1);
+    QCOMPARE(expression.distribution().last(), 8 + 4 + 1);
+}
+
+// Through the text, only the luck and resistance of the rolls get lost.
+void tst_DamageExpression::roundTrip()
+{
+    WeaponArrangement weapon;
+    weapon.damage.insert(DamageType::Piercing, DiceRoll().sides(6).bonus(1).luck(2));
+    weapon.damage.insert(DamageType::Fire, DiceRoll().number(2).sides(4).probability(0.5)
+                                                        .resistance(0.25));
+    weapon.proficiencyDamage = 2;
+
+    const DamageExpression expression = DamageExpression::fromArrangement(weapon);
+    QCOMPARE(expression.toString(), QStringLiteral("1d6+3[piercing] + 2d4[fire]@50%"));
+
+    bool ok = false;
+    const DamageExpression again = DamageExpression::fromString(expression.toString(), &ok);
+    QVERIFY(ok);
+    QCOMPARE(again.terms().size(), expression.terms().size());
+    for (int index = 0; index < again.terms().size(); ++index) {
+        const DamageExpression::Term& original = expression.terms().at(index);
+        const DamageExpression::Term& parsed = again.terms().at(index);
+        QVERIFY(parsed.type == original.type);
+        QCOMPARE(parsed.roll.probability(), original.roll.probability());
+        QCOMPARE(parsed.roll.luck(), 0);
+        QCOMPARE(parsed.roll.resistance(), 0.0);
+        QVERIFY(parsed.roll == DiceRoll(original.roll).luck(0).resistance(0.0));
+    }
+    QVERIFY(!(again.terms() == expression.terms()));
+}
+
+QTEST_MAIN(tst_DamageExpression)
+
+#include "tst_damageexpression.moc"
@@ -0,0 +1,174 @@
+/*
+ * This file is part of Moebius Toolkit.
+ * Copyright (C) 2026 Alejandro Exojo Piqueras
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <QtTest>
+
+#include "calculators.h"
+#include "damagegraph.h"
+#include "diceroll.h"
+
+#include <functional>
+
+using namespace Calculators;
+
+class tst_DamageGraph : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void firstEvaluation();
+    void edits();
+    void offHand();
+
+private:
+    // The same values as Damage::averageDamages() (only the order of the
+    // additions differs).
+    void verifyDamages(DamageGraph& graph)
+    {
+        const QVector<double> expected = Damage(m_weapon1, m_weapon2, m_common).averageDamages(m_sweep);
+        const QVector<double>& damages = graph.averageDamages();
+        QCOMPARE(damages.size(), expected.size());
+        for (int index = 0; index < expected.size(); ++index)
+            QVERIFY(qAbs(damages.at(index) - expected.at(index)) < 1e-9);
+    }
+
+    void setAll(DamageGraph& graph)
+    {
+        graph.setArrangement(Damage::One, m_weapon1);
+        graph.setArrangement(Damage::Two, m_weapon2);
+        graph.setCommon(m_common);
+        graph.setSweep(m_sweep);
+    }
+
+    WeaponArrangement m_weapon1, m_weapon2;
+    Damage::Common m_common;
+    Damage::Sweep m_sweep;
+};
+
+void tst_DamageGraph::initTestCase()
+{
+    m_weapon1.damage.insert(DamageType::Slashing, DiceRoll().sides(8).bonus(2));
+    m_weapon1.damage.insert(DamageType::Cold, DiceRoll().number(0).bonus(1));
+    m_weapon1.attacks = 2.5;
+    m_weapon1.criticalHit = 10;
+    m_weapon2.damage.insert(DamageType::Crushing, DiceRoll().sides(4).bonus(3));
+    m_weapon2.damage.insert(DamageType::Electricity, DiceRoll().number(0).bonus(1));
+    m_weapon2.styleToHit = -4;
+    m_common.thac0 = 8;
+    m_common.statToHit = 3;
+    m_common.statDamage = 7;
+    m_sweep.offHand = true;
+    m_sweep.acModifier2 = -2;
+}
+
+void tst_DamageGraph::firstEvaluation()
+{
+    DamageGraph graph;
+    setAll(graph);
+    verifyDamages(graph);
+    QCOMPARE(graph.recomputedNodes(), DamageGraph::NodeCount);
+
+    // Nothing changed, or set again to the same values.
+    graph.averageDamages();
+    QCOMPARE(graph.recomputedNodes(), 0);
+    setAll(graph);
+    graph.averageDamages();
+    QCOMPARE(graph.recomputedNodes(), 0);
+}
+
+// Each edit from the same starting point, against how many nodes depend on it.
+void tst_DamageGraph::edits()
+{
+    struct Edit
+    {
+        const char* name;
+        std::function<void()> apply;
+        int recomputed;
+    };
+    const QVector<Edit> edits = {
+        // The table of hits of the first hand, and the sum.
+        {"enemy AC modifier", [this] { m_sweep.acModifier1 = 3; }, 2},
+        // Only the elemental of the second hand, its total, its critical
+        // damage, and the sum.
+        {"elemental dice", [this] { m_weapon2.damage[DamageType::Electricity].bonus(2); }, 4},
+        {"elemental probability", [this] {
+            m_weapon2.damage[DamageType::Electricity].probability(0.5);
+        }, 4},
+        // The physical damage of both hands, and what depends on it.
+        {"damage bonus", [this] { m_common.otherDamage = 2; }, 7},
+        {"maximum damage", [this] { m_sweep.maximumDamage = true; }, 7},
+        // The THAC0 and table of hits of both hands, and the sum.
+        {"THAC0", [this] { m_common.thac0 = 10; }, 5},
+        {"Critical Strike", [this] { m_sweep.criticalStrike = true; }, 3},
+        {"helmet", [this] { m_sweep.doubleCriticalDamage = false; }, 3},
+        {"attacks", [this] { m_weapon1.attacks = 3; }, 2},
+        // The bonuses to hit are an input only by their total.
+        {"same bonus to hit", [this] {
+            m_weapon1.styleToHit = -1;
+            m_weapon1.weaponToHit = 1;
+        }, 0},
+        // A critical miss that still misses only with a 1: the table gets
+        // recomputed, but it's the same, so the sum is not.
+        {"same table", [this] { m_weapon1.criticalMiss = 9; }, 1},
+    };
+
+    const WeaponArrangement weapon1 = m_weapon1, weapon2 = m_weapon2;
+    const Damage::Common common = m_common;
+    const Damage::Sweep sweep = m_sweep;
+    for (const Edit& edit : edits) {
+        DamageGraph graph;
+        setAll(graph);
+        graph.averageDamages();
+        edit.apply();
+        setAll(graph);
+        verifyDamages(graph);
+        QVERIFY2(graph.recomputedNodes() == edit.recomputed, edit.name);
+
+        m_weapon1 = weapon1;
+        m_weapon2 = weapon2;
+        m_common = common;
+        m_sweep = sweep;
+    }
+}
+
+// Only the main hand, until the off hand gets enabled, and then only it.
+void tst_DamageGraph::offHand()
+{
+    m_sweep.offHand = false;
+    DamageGraph graph;
+    setAll(graph);
+    verifyDamages(graph);
+    const int handNodes = (DamageGraph::NodeCount - 1) / 2;
+    QCOMPARE(graph.recomputedNodes(), handNodes + 1);
+
+    m_weapon2.criticalHit = 15;
+    setAll(graph);
+    graph.averageDamages();
+    QCOMPARE(graph.recomputedNodes(), 0);
+
+    m_sweep.offHand = true;
+    setAll(graph);
+    verifyDamages(graph);
+    QCOMPARE(graph.recomputedNodes(), handNodes + 1);
+}
+
+QTEST_MAIN(tst_DamageGraph)
+
+#include "tst_damagegraph.moc"
@@ -0,0 +1,156 @@
+/*
+ * This file is part of Moebius Toolkit.
+ * Copyright (C) 2026 Alejandro Exojo Piqueras
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtTest>
+
+#include "calculators.h"
+#include "damagesweep.h"
+
+using namespace Calculators;
+using namespace DamageSweep;
+
+class tst_DamageSweep : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void bonuses();
+    void proficiencyBonuses();
+    void points();
+    void evaluate();
+    void threads();
+
+private:
+    Grid grid() const
+    {
+        Grid result;
+        result.weapon.damage.insert(DamageType::Slashing, DiceRoll().sides(8).bonus(2));
+        result.weapon.damage.insert(DamageType::Cold, DiceRoll().number(0).bonus(1));
+        result.weapon.criticalHit = 10;
+        result.common.otherDamage = 1;
+        result.thac0 = {20, 15, 10, 5, 0};
+        result.strength = {16, 18, 19, 25};
+        result.proficiency = {0, 1, 2, 3, 4, 5};
+        result.attacks = {1.0, 1.5, 2.0, 2.5};
+        result.acFrom = 5;
+        result.acTo = -5;
+        return result;
+    }
+};
+
+void tst_DamageSweep::bonuses()
+{
+    QCOMPARE(strengthBonus(10).toHit, 0);
+    QCOMPARE(strengthBonus(16).damage, 1);
+    QCOMPARE(strengthBonus(18).toHit, 1);
+    QCOMPARE(strengthBonus(18).damage, 2);
+    QCOMPARE(strengthBonus(19).damage, 7);
+    QCOMPARE(strengthBonus(25).toHit, 7);
+    QCOMPARE(strengthBonus(25).damage, 14);
+    QCOMPARE(proficiencyBonus(0).toHit, -2);
+    QCOMPARE(proficiencyBonus(2).damage, 2);
+    QCOMPARE(proficiencyBonus(5).damage, 5);
+}
+
+// The same as the tooltips of WeaponArrangementWidget (wspecial.2da).
+void tst_DamageSweep::proficiencyBonuses()
+{
+    const QVector<QPair<int, int>> expected = {
+        {-2, 0}, // Unskilled
+        {0, 0},  // Proficient
+        {1, 2},  // Specialized
+        {3, 3},  // Master
+        {3, 4},  // High master
+        {3, 5},  // Grand master
+    };
+    for (int points = 0; points < expected.size(); ++points) {
+        const Bonus bonus = proficiencyBonus(points);
+        QCOMPARE(bonus.toHit, expected.at(points).first);
+        QCOMPARE(bonus.damage, expected.at(points).second);
+    }
+}
+
+void tst_DamageSweep::points()
+{
+    const Grid input = grid();
+    QCOMPARE(input.size(), qint64(5 * 4 * 6 * 4 * 11));
+
+    Results results;
+    results.grid = input;
+    const Point first = results.point(0);
+    QCOMPARE(first.thac0, 20);
+    QCOMPARE(first.strength, 16);
+    QCOMPARE(first.proficiency, 0);
+    QCOMPARE(first.attacks, 1.0);
+    QCOMPARE(first.ac, 5);
+
+    const Point last = results.point(input.size() - 1);
+    QCOMPARE(last.thac0, 0);
+    QCOMPARE(last.strength, 25);
+    QCOMPARE(last.proficiency, 5);
+    QCOMPARE(last.attacks, 2.5);
+    QCOMPARE(last.ac, -5);
+
+    // Without the parameters, the grid is only the range of armor classes.
+    results.grid = Grid();
+    results.grid.acTo = 3;
+    QCOMPARE(results.grid.size(), qint64(4));
+    QCOMPARE(results.point(3).ac, 3);
+    QCOMPARE(results.point(3).strength, -1);
+    QCOMPARE(results.point(3).thac0, results.grid.common.thac0);
+}
+
+// Each row, against setting up the calculator with the values of the point.
+void tst_DamageSweep::evaluate()
+{
+    const Results results = DamageSweep::evaluate(grid(), {1});
+    QCOMPARE(results.damage.size(), int(results.grid.size()));
+    QCOMPARE(results.hitChance.size(), int(results.grid.size()));
+
+    for (int row = 0; row < results.damage.size(); ++row) {
+        const Point point = results.point(row);
+        Damage::Common common = results.grid.common;
+        common.thac0 = point.thac0;
+        common.statToHit = strengthBonus(point.strength).toHit;
+        common.statDamage = strengthBonus(point.strength).damage;
+        WeaponArrangement weapon = results.grid.weapon;
+        weapon.proficiencyToHit = proficiencyBonus(point.proficiency).toHit;
+        weapon.proficiencyDamage = proficiencyBonus(point.proficiency).damage;
+        weapon.attacks = point.attacks;
+        const Damage damage(weapon, weapon, common);
+
+        const auto hits = damage.hitDistribution(Damage::One, point.ac);
+        const double expected = point.attacks / 20
+                * (hits.first * damage.onHitDamage(Damage::One, Damage::Regular)
+                   + hits.second * damage.onHitDamage(Damage::One, Damage::Critical));
+        QVERIFY(qAbs(results.damage.at(row) - expected) < 1e-4 * expected + 1e-6);
+        QCOMPARE(results.hitChance.at(row), float((hits.first + hits.second) / 20.0));
+    }
+}
+
+void tst_DamageSweep::threads()
+{
+    const Results one = DamageSweep::evaluate(grid(), {1});
+    const Results many = DamageSweep::evaluate(grid(), {4});
+    QCOMPARE(many.damage, one.damage);
+    QCOMPARE(many.hitChance, one.hitChance);
+}
+
+QTEST_MAIN(tst_DamageSweep)
+
+#include "tst_damagesweep.moc"
@@ -19,6 +19,12 @@
 #include <QtTest>
 
 #include "diceroll.h"
+#include "dicerollbatch.h"
+#include "dicetables.h"
+#include "fixeddice.h"
+
+#include <numeric>
+#include <vector>
 
 class tst_DiceRoll: public QObject
 {
@@ -28,8 +34,18 @@ private slots:
     void debugOperatorAndConstructor();
     void setters();
     void permutations();
+    void outcomes();
+    void distribution();
+    void sigmaWithoutResistance();
+    void cache();
+    void tables();
+    void fixedDice();
+    void batch();
+    void cumulative();
+    void counts();
     void luckified();
     void resistified();
+    void remapTables();
     void test_data();
     void test();
 };
@@ -128,6 +144,334 @@ void tst_DiceRoll::permutations()
     QCOMPARE(dice.permutations(), result);
 }
 
+void tst_DiceRoll::outcomes()
+{
+    for (const auto& dice : {DiceRoll().number(0), DiceRoll().sides(10).luck(2),
+                             DiceRoll().number(2).sides(4).luck(-1),
+                             DiceRoll().number(3).sides(3)})
+    {
+        const auto outcomes = dice.outcomes();
+        DiceRoll::Permutations visited;
+        for (const QVector<int>& rolls : outcomes)
+            visited.append(rolls);
+        QCOMPARE(qint64(visited.size()), outcomes.size());
+        QCOMPARE(visited, dice.permutations());
+    }
+
+    // The buffer is reused: the address of the rolls doesn't change.
+    const auto outcomes = DiceRoll().number(3).sides(6).outcomes();
+    auto iterator = outcomes.begin();
+    const int* buffer = iterator->constData();
+    int count = 0;
+    for (; iterator != outcomes.end(); ++iterator, ++count)
+        QCOMPARE(iterator->constData(), buffer);
+    QCOMPARE(count, 216);
+}
+
+void tst_DiceRoll::distribution()
+{
+    auto dice = DiceRoll().number(2).sides(6);
+    auto result = dice.distribution();
+    QCOMPARE(result.first(), 2);
+    QCOMPARE(result.last(), 12);
+    QCOMPARE(result.probability(7), 6.0/36);
+    QCOMPARE(result.probability(12), 1.0/36);
+    QCOMPARE(result.probability(13), 0.0);
+
+    // Luck makes the lowest values impossible, so they are not in the range.
+    dice = DiceRoll().sides(10).luck(2).bonus(1);
+    result = dice.distribution();
+    QCOMPARE(result.first(), 4);
+    QCOMPARE(result.last(), 11);
+    QCOMPARE(result.probability(11), 0.3);
+
+    // Resistance: 1, 2, 3, 4 become 1, 1, 2, 2.
+    dice = DiceRoll().sides(4).resistance(0.5);
+    QCOMPARE(dice.distribution(), Distribution(1, {0.5, 0.5}));
+
+    // The effect not happening is the same as doing 0 damage.
+    dice = DiceRoll().sides(4).probability(0.5);
+    QCOMPARE(dice.distribution(), Distribution(0, {0.5, 0.125, 0.125, 0.125, 0.125}));
+    QCOMPARE(dice.average(), 1.25);
+    QCOMPARE(dice.sigma(), qSqrt(2.1875));
+
+    // Compare with counting each permutation, which is slow, but obviously right.
+    for (const auto& roll : {DiceRoll().number(3).sides(4).luck(-1),
+                             DiceRoll().number(2).sides(8).bonus(3).luck(2),
+                             DiceRoll().number(4).sides(3).bonus(1).resistance(0.5)})
+    {
+        const auto permutations = roll.permutations();
+        QVector<double> counted(roll.maximum() + 1, 0.0);
+        for (const QVector<int>& rolls : permutations) {
+            const int value = std::accumulate(rolls.begin(), rolls.end(), roll.bonus());
+            counted[roll.resistified(value)] += 1.0 / permutations.size();
+        }
+        QCOMPARE(roll.distribution(), Distribution(0, counted));
+    }
+
+    // Too slow with permutations: 60 million of them.
+    dice = DiceRoll().number(10).sides(6);
+    result = dice.distribution();
+    QCOMPARE(result.size(), 51);
+    QCOMPARE(result.mean(), 35.0);
+    QCOMPARE(result.variance(), 10 * 35.0/12);
+}
+
+// Without resistance sigma() is calculated from the moments of a single dice,
+// so compare it with the variance of the full PMF.
+void tst_DiceRoll::sigmaWithoutResistance()
+{
+    for (int number : {0, 1, 2, 5, 20}) {
+        for (int luck : {-3, 0, 1, 20}) {
+            for (double probability : {1.0, 0.5, 0.1}) {
+                const auto dice = DiceRoll().number(number).sides(8).bonus(2)
+                                            .luck(luck).probability(probability);
+                const Distribution distribution = dice.distribution();
+                const double mu = dice.average();
+                double variance = 0.0;
+                for (int value = distribution.first(); value <= distribution.last(); ++value)
+                    variance += distribution.probability(value) * qPow(value - mu, 2);
+                QCOMPARE(dice.sigma() + 1.0, qSqrt(variance) + 1.0);
+            }
+        }
+    }
+}
+
+void tst_DiceRoll::cache()
+{
+    DiceRoll::clearCache();
+    auto statistics = DiceRoll::cacheStatistics();
+    QCOMPARE(statistics.hits, qint64(0));
+    QCOMPARE(statistics.misses, qint64(0));
+    QCOMPARE(statistics.size, 0);
+
+    // Not one of the common weapon dice, which skip the cache.
+    const auto dice = DiceRoll().number(3).sides(6).bonus(1).luck(1);
+    const double average = dice.average();
+    QCOMPARE(DiceRoll::cacheStatistics().misses, qint64(1));
+    QCOMPARE(dice.average(), average);
+    QCOMPARE(DiceRoll::cacheStatistics().hits, qint64(1));
+
+    // Same roll, but a different statistic.
+    dice.distribution();
+    QCOMPARE(DiceRoll::cacheStatistics().misses, qint64(2));
+    QCOMPARE(DiceRoll::cacheStatistics().size, 1);
+
+    // A different roll, even if only slightly.
+    QVERIFY(dice.resistance(0.1).average() != average);
+    QCOMPARE(DiceRoll::cacheStatistics().misses, qint64(3));
+    QCOMPARE(DiceRoll::cacheStatistics().size, 2);
+
+    // The cache is bounded, but the results are the same.
+    const int capacity = DiceRoll::cacheStatistics().capacity;
+    DiceRoll::setCacheCapacity(3);
+    for (int bonus = 0; bonus < 10; ++bonus)
+        QCOMPARE(dice.bonus(bonus).average(), 13.0 + bonus);
+    QVERIFY(DiceRoll::cacheStatistics().size <= 3);
+    DiceRoll::setCacheCapacity(capacity);
+    DiceRoll::clearCache();
+}
+
+// Compare the tables generated at compile time with counting the outcomes, and
+// the statistics with the ones that loop over the values of each dice.
+void tst_DiceRoll::tables()
+{
+    const QVector<QPair<int, int>> shapes = {
+        {1, 2}, {1, 3}, {1, 4}, {1, 6}, {1, 8}, {1, 10}, {1, 12}, {2, 4}, {2, 6}, {1, 20}
+    };
+    for (const auto& [number, sides] : shapes) {
+        for (int luck = DiceTables::MinimumLuck; luck <= DiceTables::MaximumLuck; ++luck) {
+            const DiceTables::Table* table = DiceTables::find(number, sides, luck);
+            QVERIFY(table);
+            QCOMPARE(table->total, int(qPow(sides, number)));
+
+            const auto dice = DiceRoll().number(number).sides(sides).luck(luck).bonus(2);
+            QVector<int> counts(DiceTables::MaximumValue + 1, 0);
+            for (const QVector<int>& rolls : dice.outcomes())
+                ++counts[std::accumulate(rolls.begin(), rolls.end(), 0)];
+            for (int value = 0; value <= DiceTables::MaximumValue; ++value)
+                QCOMPARE(table->counts[value], counts.at(value));
+
+            double average = 0.0;
+            for (int x = 1; x <= sides; ++x)
+                average += number * dice.luckified(x) + dice.bonus();
+            average /= sides;
+            QCOMPARE(dice.average(), average);
+            QCOMPARE(dice.probability(0.25).average(), average * 0.25);
+
+            // The resistance avoids the table, so it takes the other path.
+            const auto resisted = dice.resistance(0.0001);
+            QCOMPARE(dice.sigma(), resisted.sigma());
+            QCOMPARE(dice.probability(0.25).sigma(), resisted.probability(0.25).sigma());
+            QCOMPARE(dice.distribution(), resisted.distribution());
+        }
+    }
+
+    QVERIFY(!DiceTables::find(3, 6, 0));
+    QVERIFY(!DiceTables::find(1, 7, 0));
+    QVERIFY(!DiceTables::find(0, 6, 0));
+    // Luck beyond what can change the dice uses the last table.
+    QCOMPARE(DiceTables::find(1, 6, 100), DiceTables::find(1, 6, 5));
+}
+
+// The specializations, against the average of each face with the resistance
+// applied one by one, like calculateAverage() does.
+void tst_DiceRoll::fixedDice()
+{
+    const QVector<QPair<int, int>> shapes = {
+        {1, 2}, {1, 3}, {1, 4}, {1, 6}, {1, 8}, {1, 10}, {1, 12}, {2, 4}, {2, 6}, {1, 20}
+    };
+    for (const auto& [number, sides] : shapes) {
+        for (int luck = -21; luck <= 21; ++luck) {
+            for (double resistance : {0.0, 0.1, 0.25, 0.5, 0.9, 1.0}) {
+                const auto dice = DiceRoll().number(number).sides(sides).luck(luck)
+                        .bonus(3).resistance(resistance).probability(0.75);
+                double average = 0.0;
+                for (int x = 1; x <= sides; ++x)
+                    average += dice.resistified(number * dice.luckified(x) + dice.bonus());
+                average /= sides;
+                average *= 0.75;
+                QCOMPARE(dice.average(), average);
+            }
+        }
+    }
+
+    double result = -1.0;
+    QVERIFY(!FixedDiceDispatch::average(3, 6, 0, 0, 0.0, 1.0, result));
+    QVERIFY(!FixedDiceDispatch::average(1, 7, 0, 0, 0.0, 1.0, result));
+    QCOMPARE(result, -1.0);
+    QVERIFY(FixedDiceDispatch::average(2, 4, 1, 0, 0.0, 1.0, result));
+    QCOMPARE(result, 6.0);
+}
+
+// Every combination of a few values of each column, one roll per row.
+void tst_DiceRoll::batch()
+{
+    std::vector<int> number, sides, bonus, luck;
+    std::vector<double> resistance, probability;
+    for (int n : {0, 1, 2, 3, 7}) {
+        for (int s : {1, 2, 4, 6, 7, 20}) {
+            for (int b : {-2, 0, 3}) {
+                for (int l : {-25, -3, -1, 0, 1, 2, 5, 19}) {
+                    for (double r : {0.0, 0.0, 0.5}) {
+                        for (double p : {1.0, 0.3}) {
+                            number.push_back(n);
+                            sides.push_back(s);
+                            bonus.push_back(b);
+                            luck.push_back(l);
+                            resistance.push_back(r);
+                            probability.push_back(p);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    const std::size_t size = number.size();
+    std::vector<double> average(size), sigma(size);
+    std::vector<int> minimum(size), maximum(size);
+    DiceRollBatch::evaluate({number, sides, bonus, luck, resistance, probability},
+                            {average, sigma, minimum, maximum});
+
+    for (std::size_t row = 0; row < size; ++row) {
+        const auto roll = DiceRoll().number(number.at(row)).sides(sides.at(row))
+                                    .bonus(bonus.at(row)).luck(luck.at(row))
+                                    .resistance(resistance.at(row))
+                                    .probability(probability.at(row));
+        QCOMPARE(minimum.at(row), roll.minimum());
+        QCOMPARE(maximum.at(row), roll.maximum());
+        QCOMPARE(average.at(row), roll.average());
+        QCOMPARE(sigma.at(row), roll.sigma());
+    }
+
+    // Only what is asked for is written.
+    std::vector<int> onlyMaximum(size, 0);
+    DiceRollBatch::evaluate({number, sides, bonus, luck, resistance, probability},
+                            {.maximum = onlyMaximum});
+    QVERIFY(onlyMaximum == maximum);
+}
+
+void tst_DiceRoll::cumulative()
+{
+    // 2d6+3 doing at least 10 is 2d6 rolling 7 or more.
+    const auto roll = DiceRoll().number(2).sides(6).bonus(3);
+    QCOMPARE(roll.probabilityAtLeast(10), 21.0 / 36);
+    QCOMPARE(roll.probabilityAtLeast(5), 1.0);
+    QCOMPARE(roll.probabilityAtLeast(16), 0.0);
+    QCOMPARE(roll.quantile(0.5), 10);
+    QCOMPARE(roll.quantile(0.9), 13); // 33/36 are 12+3 or less.
+    QCOMPARE(roll.quantile(1.0), 15);
+
+    // It happens half of the time, so the median is 0 damage.
+    QCOMPARE(roll.probability(0.5).quantile(0.5), 0);
+    QCOMPARE(roll.probability(0.5).probabilityAtLeast(10), 21.0 / 72);
+
+    // Same as counting the outcomes for a bigger roll with everything.
+    const auto big = DiceRoll().number(4).sides(6).bonus(1).luck(1).resistance(0.25);
+    QVector<int> values;
+    for (const QVector<int>& rolls : big.outcomes())
+        values.append(big.resistified(std::accumulate(rolls.begin(), rolls.end(), big.bonus())));
+    std::sort(values.begin(), values.end());
+    for (int value = big.minimum() - 1; value <= big.maximum() + 1; ++value) {
+        const auto atLeast = std::count_if(values.begin(), values.end(),
+                                           [value](int x) { return x >= value; });
+        QCOMPARE(big.probabilityAtLeast(value), double(atLeast) / values.size());
+    }
+    for (double p : {0.1, 0.25, 0.5, 0.75, 0.9, 0.99}) {
+        const int index = qCeil(p * values.size()) - 1;
+        QCOMPARE(big.quantile(p), values.at(index));
+    }
+}
+
+void tst_DiceRoll::counts()
+{
+    bool ok = false;
+    const auto threeD6 = DiceRoll().number(3).sides(6).bonus(1).counts(&ok);
+    QVERIFY(ok);
+    QCOMPARE(threeD6.first, 4);
+    QCOMPARE(threeD6.last(), 19);
+    QCOMPARE(threeD6.total, quint64(216));
+    const QVector<quint64> expected = {1, 3, 6, 10, 15, 21, 25, 27, 27, 25, 21, 15, 10, 6, 3, 1};
+    QCOMPARE(threeD6.counts, expected);
+
+    // Luck +2 on a d6: the 6 has 3 faces, and resistance merges 2 values.
+    const auto lucky = DiceRoll().sides(6).luck(2).resistance(0.5).counts(&ok);
+    QVERIFY(ok);
+    QCOMPARE(lucky.first, 2); // 3 and 4
+    QCOMPARE(lucky.counts, QVector<quint64>({2, 4})); // 5 and 6 (3 faces)
+    QCOMPARE(lucky.total, quint64(6));
+
+    // 6^24 still fits in 64 bits, 6^25 doesn't.
+    const auto fits = DiceRoll().number(24).sides(6).counts(&ok);
+    QVERIFY(ok);
+    QCOMPARE(fits.total, quint64(4738381338321616896ull));
+    QCOMPARE(fits.count(24), quint64(1));
+    QCOMPARE(fits.count(25), quint64(24)); // One of the dice is a 2.
+    QCOMPARE(fits.count(144), quint64(1));
+    QCOMPARE(fits.count(145), quint64(0));
+    DiceRoll().number(25).sides(6).counts(&ok);
+    QVERIFY(!ok);
+
+    // The distributions from the exact counts, and from the doubles, agree.
+    for (const auto& roll : {DiceRoll().number(3).sides(6).bonus(1),
+                             DiceRoll().number(7).sides(8).luck(-2).probability(0.4),
+                             DiceRoll().number(10).sides(6).resistance(0.3),
+                             DiceRoll().number(30).sides(6)})
+    {
+        bool exact = false;
+        const Distribution distribution = roll.exactDistribution(&exact);
+#ifdef MOEBIUS_HAVE_INT128
+        QVERIFY(exact);
+#endif
+        QCOMPARE(distribution, roll.distribution());
+    }
+    bool exact = true;
+    const auto huge = DiceRoll().number(60).sides(20);
+    QCOMPARE(huge.exactDistribution(&exact), huge.distribution());
+    QVERIFY(!exact);
+}
+
 void tst_DiceRoll::luckified()
 {
     auto dice = DiceRoll().sides(10).luck(2);
@@ -169,6 +513,26 @@ void tst_DiceRoll::resistified()
     QCOMPARE(dice.resistified(dice.maximum()), 24);
 }
 
+void tst_DiceRoll::remapTables()
+{
+    const auto roll = DiceRoll().number(3).sides(8).bonus(2).luck(-2);
+    QCOMPARE(roll.luckTable(), QVector<int>({1, 1, 1, 2, 3, 4, 5, 6}));
+    for (double resistance = 0.0; resistance <= 1.0; resistance += 0.05) {
+        const auto resisted = roll.resistance(resistance);
+        const QVector<int> table = resisted.resistanceTable();
+        QCOMPARE(table.size(), resisted.maximum() - resisted.minimum() + 1);
+        for (int value = resisted.minimum(); value <= resisted.maximum(); ++value)
+            QCOMPARE(table.at(value - resisted.minimum()), resisted.resistified(value));
+
+        // The remapped distribution, against applying the resistance to each
+        // value of the one without it.
+        const Distribution expected = roll.distribution()
+                .mapped([&resisted](int value) { return resisted.resistified(value); })
+                .mixed(0.3);
+        QCOMPARE(resisted.probability(0.3).distribution(), expected);
+    }
+}
+
 // Average is easy to calculate by hand, but for standard deviation another
 // source is useful, for example:
 // https://www.rapidtables.com/calc/math/variance-calculator.html
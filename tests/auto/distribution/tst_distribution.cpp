@@ -0,0 +1,271 @@
+/*
+ * This file is part of Moebius Toolkit.
+ * Copyright (C) 2026 Alejandro Exojo Piqueras
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtTest>
+
+#include "distribution.h"
+#include "distributionkernels.h"
+
+class tst_Distribution : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void constructor();
+    void statistics();
+    void convolved();
+    void shifted();
+    void mixed();
+    void mapped();
+    void remapped();
+    void cumulative();
+    void kernels();
+    void fft_data();
+    void fft();
+    void fftWithGaps();
+};
+
+void tst_Distribution::constructor()
+{
+    const Distribution nothing;
+    QCOMPARE(nothing.first(), 0);
+    QCOMPARE(nothing.last(), 0);
+    QCOMPARE(nothing.probability(0), 1.0);
+
+    // The edges that can't happen are removed. The middle is kept.
+    const Distribution trimmed(1, {0.0, 0.0, 0.5, 0.0, 0.5, 0.0});
+    QCOMPARE(trimmed.first(), 3);
+    QCOMPARE(trimmed.last(), 5);
+    QCOMPARE(trimmed.size(), 3);
+    QCOMPARE(trimmed.probability(4), 0.0);
+    QCOMPARE(trimmed.probability(5), 0.5);
+    QCOMPARE(trimmed.probability(42), 0.0);
+}
+
+void tst_Distribution::statistics()
+{
+    const Distribution d6(1, QVector<double>(6, 1.0/6));
+    QCOMPARE(d6.mean(), 3.5);
+    QCOMPARE(d6.variance(), 35.0/12);
+
+    const Distribution coin(0, {0.5, 0.5});
+    QCOMPARE(coin.mean(), 0.5);
+    QCOMPARE(coin.variance(), 0.25);
+}
+
+void tst_Distribution::convolved()
+{
+    const Distribution d4(1, QVector<double>(4, 0.25));
+    const Distribution sum = d4.convolved(d4);
+    QCOMPARE(sum, Distribution(2, {1/16.0, 2/16.0, 3/16.0, 4/16.0, 3/16.0, 2/16.0, 1/16.0}));
+
+    // Adding nothing changes nothing.
+    QCOMPARE(d4.convolved(Distribution()), d4);
+    QCOMPARE(Distribution().convolved(d4), d4);
+}
+
+void tst_Distribution::shifted()
+{
+    const Distribution d4(1, QVector<double>(4, 0.25));
+    QCOMPARE(d4.shifted(3), Distribution(4, QVector<double>(4, 0.25)));
+    QCOMPARE(d4.shifted(-3).first(), -2);
+    QCOMPARE(d4.shifted(3).mean(), 5.5);
+}
+
+void tst_Distribution::mixed()
+{
+    const Distribution d4(1, QVector<double>(4, 0.25));
+    QCOMPARE(d4.mixed(1.0), d4);
+    QCOMPARE(d4.mixed(0.0), Distribution());
+    QCOMPARE(d4.mixed(0.2), Distribution(0, {0.8, 0.05, 0.05, 0.05, 0.05}));
+    QCOMPARE(d4.mixed(0.5, Distribution().shifted(10)).last(), 10);
+    QCOMPARE(d4.mixed(0.5, Distribution().shifted(10)).probability(10), 0.5);
+}
+
+void tst_Distribution::mapped()
+{
+    const Distribution d4(1, QVector<double>(4, 0.25));
+    QCOMPARE(d4.mapped([](int value) { return value * 2; }),
+             Distribution(2, {0.25, 0.0, 0.25, 0.0, 0.25, 0.0, 0.25}));
+    QCOMPARE(d4.mapped([](int value) { return (value + 1) / 2; }),
+             Distribution(1, {0.5, 0.5}));
+}
+
+void tst_Distribution::remapped()
+{
+    const Distribution d4(1, {0.25, 0.25, 0.25, 0.25});
+    QCOMPARE(d4.remapped({1, 1, 2, 2}), Distribution(1, {0.5, 0.5}));
+    QCOMPARE(d4.remapped({5, 6, 7, 8}), d4.shifted(4));
+    // Not sorted, so the range has to be found.
+    QCOMPARE(d4.remapped({3, 0, 3, 1}), Distribution(0, {0.25, 0.25, 0.0, 0.5}));
+
+    const Distribution big = Distribution(1, QVector<double>(6, 1.0 / 6)).power(10);
+    QVector<int> half;
+    for (int value = big.first(); value <= big.last(); ++value)
+        half.append(qCeil(value * 0.5));
+    QCOMPARE(big.remapped(half), big.mapped([](int value) { return qCeil(value * 0.5); }));
+}
+
+void tst_Distribution::cumulative()
+{
+    const CumulativeDistribution nothing;
+    QCOMPARE(nothing.probabilityAtLeast(0), 1.0);
+    QCOMPARE(nothing.probabilityAtLeast(1), 0.0);
+    QCOMPARE(nothing.quantile(0.5), 0);
+
+    const Distribution d4(1, {0.25, 0.25, 0.25, 0.25});
+    const CumulativeDistribution cumulative(d4);
+    QCOMPARE(cumulative.first(), 1);
+    QCOMPARE(cumulative.last(), 4);
+    QCOMPARE(cumulative.probabilityAtLeast(-10), 1.0);
+    QCOMPARE(cumulative.probabilityAtLeast(1), 1.0);
+    QCOMPARE(cumulative.probabilityAtLeast(2), 0.75);
+    QCOMPARE(cumulative.probabilityAtLeast(4), 0.25);
+    QCOMPARE(cumulative.probabilityAtLeast(5), 0.0);
+    QCOMPARE(cumulative.probabilityAtMost(0), 0.0);
+    QCOMPARE(cumulative.probabilityAtMost(3), 0.75);
+    QCOMPARE(cumulative.probabilityAtMost(10), 1.0);
+
+    QCOMPARE(cumulative.quantile(0.0), 1);
+    QCOMPARE(cumulative.quantile(0.25), 1);
+    QCOMPARE(cumulative.quantile(0.26), 2);
+    QCOMPARE(cumulative.quantile(0.5), 2);
+    QCOMPARE(cumulative.quantile(0.9), 4);
+    QCOMPARE(cumulative.quantile(1.0), 4);
+
+    // Gaps in the middle don't get chosen as quantiles.
+    const CumulativeDistribution gaps(Distribution(0, {0.5, 0.0, 0.0, 0.5}));
+    QCOMPARE(gaps.quantile(0.5), 0);
+    QCOMPARE(gaps.quantile(0.6), 3);
+    QCOMPARE(gaps.probabilityAtLeast(1), 0.5);
+
+    // The tails don't lose precision with subtractions from 1.
+    const Distribution tiny(0, {1.0 - 1e-20, 1e-20});
+    QCOMPARE(CumulativeDistribution(tiny).probabilityAtLeast(1), 1e-20);
+}
+
+// Whatever implementation the CPU running the test picks, it has to give the
+// same results as the scalar one. Sizes not multiple of the vector width too.
+void tst_Distribution::kernels()
+{
+    const auto& scalar = DistributionKernels::scalar();
+    const auto& native = DistributionKernels::native();
+    qDebug() << "Native implementation:" << native.name;
+
+    for (int aSize : {1, 3, 4, 7, 20}) {
+        for (int bSize : {1, 2, 5, 8, 13, 64}) {
+            QVector<double> a(aSize), b(bSize);
+            for (int i = 0; i < aSize; ++i)
+                a[i] = 1.0 / (i + 3);
+            for (int i = 0; i < bSize; ++i)
+                b[i] = 1.0 / (2 * i + 1);
+
+            QVector<double> expected(aSize + bSize - 1, 0.0);
+            QVector<double> result(aSize + bSize - 1, 0.0);
+            scalar.convolve(a.constData(), aSize, b.constData(), bSize, expected.data());
+            native.convolve(a.constData(), aSize, b.constData(), bSize, result.data());
+            QVERIFY(result == expected);
+
+            expected = b;
+            result = b;
+            scalar.scale(expected.data(), bSize, 0.3);
+            native.scale(result.data(), bSize, 0.3);
+            QVERIFY(result == expected);
+
+            scalar.accumulate(expected.data(), b.constData(), bSize, 0.7);
+            native.accumulate(result.data(), b.constData(), bSize, 0.7);
+            QVERIFY(result == expected);
+        }
+    }
+}
+
+void tst_Distribution::fft_data()
+{
+    QTest::addColumn<int>("number");
+    QTest::addColumn<int>("sides");
+
+    QTest::newRow("3d6") << 3 << 6; // Small enough to not use the FFT.
+    QTest::newRow("40d4") << 40 << 4;
+    QTest::newRow("20d6") << 20 << 6;
+    QTest::newRow("15d8") << 15 << 8;
+    QTest::newRow("30d20") << 30 << 20;
+    QTest::newRow("100d6") << 100 << 6;
+}
+
+// Compare with convolving one dice at a time with the scalar kernel. The FFT
+// noise is relative to the biggest probability, not to each one, so the values
+// in the tails can be off relatively, but never by more than ~1e-16 absolute.
+void tst_Distribution::fft()
+{
+    QFETCH(int, number);
+    QFETCH(int, sides);
+
+    const QVector<double> oneDice(sides, 1.0 / sides);
+    QVector<double> expected = {1.0};
+    for (int dice = 0; dice < number; ++dice) {
+        QVector<double> next(expected.size() + sides - 1, 0.0);
+        DistributionKernels::scalar().convolve(oneDice.constData(), sides,
+                                               expected.constData(), expected.size(),
+                                               next.data());
+        expected = next;
+    }
+
+    const Distribution result = Distribution(1, oneDice).power(number);
+    QCOMPARE(result.first(), number);
+    QCOMPARE(result.last(), number * sides);
+    double sum = 0.0;
+    for (int index = 0; index < result.size(); ++index) {
+        const double probability = result.probabilities().at(index);
+        QVERIFY(probability > 0.0);
+        QVERIFY(qAbs(probability - expected.at(index)) < 1e-9 * expected.at(index) + 1e-15);
+        sum += probability;
+    }
+    QVERIFY(qAbs(sum - 1.0) < 1e-12);
+    QVERIFY(qAbs(result.mean() - number * (sides + 1) / 2.0) < 1e-9);
+
+    // Same with the two big halves, convolved with each other.
+    const Distribution half = Distribution(1, oneDice).power(number / 2);
+    const Distribution other = Distribution(1, oneDice).power(number - number / 2);
+    const Distribution sumOfHalves = half.convolved(other);
+    QCOMPARE(sumOfHalves.first(), result.first());
+    QCOMPARE(sumOfHalves.size(), result.size());
+    for (int index = 0; index < result.size(); ++index) {
+        QVERIFY(qAbs(sumOfHalves.probabilities().at(index) - expected.at(index))
+                < 1e-9 * expected.at(index) + 1e-15);
+    }
+}
+
+// Values that can't happen must stay at exactly 0, not at the FFT noise.
+void tst_Distribution::fftWithGaps()
+{
+    const Distribution evens(0, {0.5, 0.0, 0.5});
+    const Distribution result = evens.power(100);
+    QCOMPARE(result.first(), 0);
+    QCOMPARE(result.last(), 200);
+    for (int value = 0; value <= 200; ++value) {
+        if (value % 2)
+            QCOMPARE(result.probability(value), 0.0);
+        else
+            QVERIFY(result.probability(value) > 0.0);
+    }
+    QVERIFY(qAbs(result.mean() - 100.0) < 1e-9);
+}
+
+QTEST_MAIN(tst_Distribution)
+
+#include "tst_distribution.moc"
@@ -0,0 +1,166 @@
+/*
+ * This file is part of Moebius Toolkit.
+ * Copyright (C) 2026 Alejandro Exojo Piqueras
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtTest>
+
+#include "calculators.h"
+#include "diceroll.h"
+#include "montecarlo.h"
+
+using namespace Calculators;
+using namespace MonteCarlo;
+
+class tst_MonteCarlo : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void philox();
+    void bounded();
+    void reproducible();
+    void diceRoll_data();
+    void diceRoll();
+    void damage();
+};
+
+// Known answers from the Random123 distribution (kat_vectors).
+void tst_MonteCarlo::philox()
+{
+    struct Vector {
+        Philox::Counter counter;
+        Philox::Key key;
+        Philox::Counter expected;
+    };
+    const Vector vectors[] = {
+        {{0, 0, 0, 0}, {0, 0},
+         {0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8}},
+        {{0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff}, {0xffffffff, 0xffffffff},
+         {0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd}},
+        {{0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344}, {0xa4093822, 0x299f31d0},
+         {0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}},
+    };
+    for (const Vector& vector : vectors)
+        QVERIFY(Philox::block(vector.counter, vector.key) == vector.expected);
+}
+
+void tst_MonteCarlo::bounded()
+{
+    Philox random(42);
+    QVector<int> counts(6, 0);
+    for (int i = 0; i < 60000; ++i)
+        ++counts[int(random.bounded(6))];
+    for (int count : counts)
+        QVERIFY(qAbs(count - 10000) < 500);
+
+    for (int i = 0; i < 1000; ++i) {
+        const double value = random.uniform();
+        QVERIFY(value >= 0.0 && value < 1.0);
+    }
+
+    // Different streams of the same seed are different sequences.
+    Philox a(42, 0), b(42, 1);
+    QVERIFY(a() != b() || a() != b());
+}
+
+// The same seed has to give the same estimate, however the work gets split.
+void tst_MonteCarlo::reproducible()
+{
+    const auto roll = DiceRoll().number(3).sides(6).bonus(2).probability(0.7);
+    Options options;
+    options.samples = 300000;
+    options.seed = 1234;
+
+    options.threads = 1;
+    const Estimate single = estimate(roll, options);
+    for (int threads : {2, 3, 8}) {
+        options.threads = threads;
+        const Estimate multiple = estimate(roll, options);
+        QCOMPARE(multiple.samples, single.samples);
+        QVERIFY(multiple.mean == single.mean);
+        QVERIFY(multiple.variance == single.variance);
+    }
+
+    options.seed = 4321;
+    QVERIFY(estimate(roll, options).mean != single.mean);
+}
+
+void tst_MonteCarlo::diceRoll_data()
+{
+    QTest::addColumn<DiceRoll>("roll");
+
+    QTest::newRow("1d6") << DiceRoll().sides(6);
+    QTest::newRow("2d4+1") << DiceRoll().number(2).sides(4).bonus(1);
+    QTest::newRow("1d8+2@+3") << DiceRoll().sides(8).bonus(2).luck(3);
+    QTest::newRow("4d10@-2") << DiceRoll().number(4).sides(10).luck(-2);
+    QTest::newRow("3d6 50%") << DiceRoll().number(3).sides(6).probability(0.5);
+    QTest::newRow("10d6 r=0.5") << DiceRoll().number(10).sides(6).resistance(0.5);
+    QTest::newRow("2d8+3 r=0.3 25%")
+            << DiceRoll().number(2).sides(8).bonus(3).resistance(0.3).probability(0.25);
+}
+
+// The exact mean and deviation are the ones of the PMF. The interval of the
+// mean is a 99.9% one, and the seed fixed, so this doesn't fail randomly.
+void tst_MonteCarlo::diceRoll()
+{
+    QFETCH(DiceRoll, roll);
+    Options options;
+    options.samples = 1000000;
+    options.seed = 7;
+    const Estimate result = estimate(roll, options);
+    QCOMPARE(result.samples, qint64(1000000));
+
+    const Distribution distribution = roll.distribution();
+    QVERIFY2(result.contains(distribution.mean()),
+             qPrintable(QString::fromLatin1("%1 not in [%2, %3]")
+                        .arg(distribution.mean()).arg(result.lower()).arg(result.upper())));
+    QVERIFY(qAbs(result.sigma() - qSqrt(distribution.variance())) < 0.01 * result.sigma() + 1e-3);
+    if (qFuzzyIsNull(roll.resistance()))
+        QVERIFY(result.contains(roll.average()));
+}
+
+void tst_MonteCarlo::damage()
+{
+    WeaponArrangement weapon;
+    weapon.damage.insert(DamageType::Slashing, DiceRoll().sides(8).bonus(2));
+    weapon.damage.insert(DamageType::Fire, DiceRoll().sides(6).probability(0.5));
+    weapon.criticalHit = 10;
+    weapon.proficiencyDamage = 2;
+    Damage::Common common;
+    common.thac0 = 10;
+    common.statDamage = 3;
+    const Damage damage(weapon, weapon, common);
+
+    Options options;
+    options.samples = 1000000;
+    options.seed = 99;
+
+    for (int ac : {10, 0, -5, -10}) {
+        for (Damage::Stat critical : {Damage::Regular, Damage::Critical}) {
+            const auto [hits, criticals] = damage.hitDistribution(Damage::One, ac);
+            const double expected = (hits * damage.onHitDamage(Damage::One, Damage::Regular)
+                                    + criticals * damage.onHitDamage(Damage::One, critical)) / 20;
+            const Estimate result = MonteCarlo::estimate(damage, {Damage::One, ac, critical},
+                                                         options);
+            QVERIFY(result.contains(expected));
+        }
+    }
+}
+
+QTEST_MAIN(tst_MonteCarlo)
+
+#include "tst_montecarlo.moc"
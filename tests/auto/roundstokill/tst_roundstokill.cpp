@@ -0,0 +1,136 @@
+/*
+ * This file is part of Moebius Toolkit.
+ * Copyright (C) 2026 Alejandro Exojo Piqueras
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtTest>
+
+#include "calculators.h"
+#include "diceroll.h"
+#include "distribution.h"
+#include "roundstokill.h"
+
+using namespace Calculators;
+
+class tst_RoundsToKill : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void certainDamage();
+    void geometric();
+    void hitPointsDistribution();
+    void neverDies();
+    void cycle();
+    void damage();
+};
+
+void tst_RoundsToKill::certainDamage()
+{
+    const RoundsToKill::Result result = RoundsToKill::calculate(Distribution(3, {1.0}), 10);
+    QCOMPARE(result.killedBy, QVector<double>({0.0, 0.0, 0.0, 1.0}));
+    QCOMPARE(result.mean, 4.0);
+    QCOMPARE(result.quantile(0.5), 4);
+
+    // More damage than the hit points in one round.
+    const RoundsToKill::Result overkill = RoundsToKill::calculate(Distribution(30, {1.0}), 10);
+    QCOMPARE(overkill.killedBy, QVector<double>({1.0}));
+    QCOMPARE(overkill.mean, 1.0);
+}
+
+// Half of the rounds miss, and the other half kill.
+void tst_RoundsToKill::geometric()
+{
+    const RoundsToKill::Result result = RoundsToKill::calculate(Distribution(0, {0.5, 0.5}), 1);
+    QCOMPARE(result.mean, 2.0);
+    for (int round = 0; round < 10; ++round)
+        QCOMPARE(result.killedBy.at(round), 1.0 - qPow(0.5, round + 1));
+    QCOMPARE(result.quantile(0.5), 1);
+    QCOMPARE(result.quantile(0.9), 4);
+}
+
+void tst_RoundsToKill::hitPointsDistribution()
+{
+    // 1 or 2 hit points, and 1 damage per round.
+    const RoundsToKill::Result result =
+            RoundsToKill::calculate(Distribution(1, {1.0}), Distribution(1, {0.5, 0.5}));
+    QCOMPARE(result.killedBy, QVector<double>({0.5, 1.0}));
+    QCOMPARE(result.mean, 1.5);
+}
+
+void tst_RoundsToKill::neverDies()
+{
+    const RoundsToKill::Result result = RoundsToKill::calculate(Distribution(), 5, 20);
+    QCOMPARE(result.killedBy.size(), 20);
+    QCOMPARE(result.killedBy.last(), 0.0);
+    QVERIFY(qIsInf(result.mean));
+    QCOMPARE(result.quantile(0.5), -1);
+}
+
+void tst_RoundsToKill::cycle()
+{
+    // 1 and 2 damage in alternate rounds: 1, 3 and 4 after the third round.
+    const QVector<Distribution> alternate = {Distribution(1, {1.0}), Distribution(2, {1.0})};
+    const RoundsToKill::Result result = RoundsToKill::calculate(alternate, Distribution(4, {1.0}));
+    QCOMPARE(result.killedBy, QVector<double>({0.0, 0.0, 1.0}));
+    QCOMPARE(result.mean, 3.0);
+
+    // With 3 hit points it dies in the second round, so the mean is not the
+    // one of the whole cycle.
+    QCOMPARE(RoundsToKill::calculate(alternate, Distribution(3, {1.0})).mean, 2.0);
+
+    // The exact mean, against the one from the probabilities of each round.
+    const QVector<Distribution> random = {
+        Distribution(0, {0.4, 0.0, 0.3, 0.3}), Distribution(0, {0.2, 0.5, 0.0, 0.0, 0.3})
+    };
+    const Distribution hitPoints = DiceRoll().number(3).sides(6).distribution();
+    const RoundsToKill::Result mixed = RoundsToKill::calculate(random, hitPoints, 1000);
+    double mean = 0.0;
+    for (int index = 0; index < mixed.killedBy.size(); ++index)
+        mean += 1.0 - (index == 0 ? 0.0 : mixed.killedBy.at(index - 1));
+    QVERIFY(qAbs(mixed.mean - mean) < 1e-9 * mean);
+}
+
+// A real weapon against the hit points of a creature: the exact mean, against
+// the one from the probabilities of each round.
+void tst_RoundsToKill::damage()
+{
+    WeaponArrangement weapon;
+    weapon.damage.insert(DamageType::Slashing, DiceRoll().sides(8).bonus(2));
+    weapon.damage.insert(DamageType::Fire, DiceRoll().sides(6).probability(0.5));
+    weapon.attacks = 1.5;
+    Damage::Common common;
+    common.thac0 = 10;
+    common.statDamage = 3;
+    const Damage calculator(weapon, weapon, common);
+    const Distribution hitPoints = DiceRoll().number(10).sides(8).bonus(20).distribution();
+
+    for (int ac = 10; ac >= -10; ac -= 5) {
+        const Distribution round = calculator.roundDistribution(Damage::One, ac);
+        const RoundsToKill::Result result = RoundsToKill::calculate(round, hitPoints, 1000);
+        QVERIFY(result.killedBy.last() > 1.0 - 1e-9);
+        double mean = 0.0;
+        for (int index = 0; index < result.killedBy.size(); ++index)
+            mean += 1.0 - (index == 0 ? 0.0 : result.killedBy.at(index - 1));
+        QVERIFY(qAbs(result.mean - mean) < 1e-6 * mean);
+        // The killing blow can overshoot, so it takes at least this much.
+        QVERIFY(result.mean >= hitPoints.mean() / round.mean() - 1e-9);
+    }
+}
+
+QTEST_MAIN(tst_RoundsToKill)
+
+#include "tst_roundstokill.moc"
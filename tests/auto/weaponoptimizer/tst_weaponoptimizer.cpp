@@ -0,0 +1,169 @@
+/*
+ * This file is part of Moebius Toolkit.
+ * Copyright (C) 2026 Alejandro Exojo Piqueras
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QtTest>
+
+#include "calculators.h"
+#include "weaponoptimizer.h"
+
+#include <algorithm>
+
+using namespace Calculators;
+using namespace WeaponOptimizer;
+
+class tst_WeaponOptimizer : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void singleHand();
+    void bruteForce_data();
+    void bruteForce();
+
+private:
+    // A varied catalog: different dice, bonuses, enchantments to hit, some
+    // elemental damage, and attacks per round.
+    static QVector<WeaponArrangement> catalog(int size)
+    {
+        const DamageType physical[] = {Crushing, Missile, Piercing, Slashing};
+        const DamageType elemental[] = {Acid, Cold, Electricity, Fire};
+        QVector<WeaponArrangement> result;
+        for (int index = 0; index < size; ++index) {
+            WeaponArrangement weapon;
+            weapon.damage.insert(physical[index % 4], DiceRoll().number(1 + index % 2)
+                                 .sides(4 + 2 * (index % 4)).bonus(index % 5));
+            if (index % 3 == 0) {
+                weapon.damage.insert(elemental[index % 4],
+                                     DiceRoll().number(index % 7 / 2).sides(6).bonus(1));
+            }
+            weapon.weaponToHit = index % 6;
+            weapon.criticalHit = 5 + 5 * (index % 3 == 1);
+            weapon.attacks = 1.0 + 0.5 * (index % 4);
+            result.append(weapon);
+        }
+        return result;
+    }
+
+    // The damage of each configuration, calculated one by one.
+    static double damage(const Problem& problem, int one, int two)
+    {
+        auto resisted = [&problem](WeaponArrangement weapon) {
+            for (auto entry = weapon.damage.begin(), last = weapon.damage.end();
+                 entry != last; ++entry)
+            {
+                entry.value().resistance(problem.resistances.value(entry.key(), 0.0));
+            }
+            return weapon;
+        };
+        const WeaponArrangement weapon1 = resisted(problem.mainHand.at(one));
+        const WeaponArrangement weapon2 = two < 0 ? weapon1 : resisted(problem.offHand.at(two));
+        const Damage calculator(weapon1, weapon2, problem.common);
+        double result = 0.0;
+        for (Damage::Hand hand : {Damage::One, Damage::Two}) {
+            if (hand == Damage::Two && two < 0)
+                break;
+            const auto hits = calculator.hitDistribution(hand, problem.ac);
+            const double regular = calculator.onHitDamage(hand, Damage::Regular);
+            const double critical = calculator.onHitDamage(hand, problem.critical);
+            result += calculator.arrangement(hand).attacks
+                    * (hits.first * regular + hits.second * critical) / 20;
+        }
+        return result;
+    }
+};
+
+void tst_WeaponOptimizer::singleHand()
+{
+    Problem problem;
+    problem.mainHand = catalog(40);
+    problem.ac = -2;
+    problem.count = 3;
+    const Result result = optimize(problem);
+    QCOMPARE(result.best.size(), 3);
+
+    QVector<double> damages;
+    for (int one = 0; one < problem.mainHand.size(); ++one)
+        damages.append(damage(problem, one, -1));
+    std::sort(damages.begin(), damages.end(), std::greater<double>());
+    for (int index = 0; index < 3; ++index) {
+        QCOMPARE(result.best.at(index).offHand, -1);
+        QCOMPARE(result.best.at(index).damage, damages.at(index));
+        QCOMPARE(result.best.at(index).damage,
+                 damage(problem, result.best.at(index).mainHand, -1));
+    }
+}
+
+void tst_WeaponOptimizer::bruteForce_data()
+{
+    QTest::addColumn<bool>("sameItems");
+    QTest::addColumn<int>("count");
+    QTest::addColumn<int>("threads");
+
+    QTest::newRow("different, top 1") << false << 1 << 1;
+    QTest::newRow("different, top 10") << false << 10 << 4;
+    QTest::newRow("same items, top 5") << true << 5 << 1;
+    QTest::newRow("same items, top 20") << true << 20 << 0;
+}
+
+// Every pair, against the ones returned, which have to be the best ones.
+void tst_WeaponOptimizer::bruteForce()
+{
+    QFETCH(bool, sameItems);
+    QFETCH(int, count);
+    QFETCH(int, threads);
+
+    Problem problem;
+    problem.mainHand = catalog(60);
+    problem.offHand = problem.mainHand;
+    for (WeaponArrangement& weapon : problem.offHand) {
+        weapon.styleToHit = -4;
+        weapon.attacks = 1.0;
+    }
+    problem.sameItems = sameItems;
+    problem.common.thac0 = 12;
+    problem.common.statDamage = 3;
+    problem.ac = -2;
+    problem.resistances.insert(Fire, 0.3);
+    problem.resistances.insert(Slashing, 0.5);
+    problem.count = count;
+
+    QVector<double> damages;
+    for (int one = 0; one < problem.mainHand.size(); ++one) {
+        for (int two = 0; two < problem.offHand.size(); ++two) {
+            if (!sameItems || one != two)
+                damages.append(damage(problem, one, two));
+        }
+    }
+    std::sort(damages.begin(), damages.end(), std::greater<double>());
+
+    const Result result = optimize(problem, {threads});
+    QCOMPARE(result.best.size(), count);
+    QVERIFY(result.evaluated < problem.mainHand.size() + problem.offHand.size());
+    for (int index = 0; index < count; ++index) {
+        const Configuration& configuration = result.best.at(index);
+        QVERIFY(qAbs(configuration.damage - damages.at(index)) < 1e-9);
+        QVERIFY(qAbs(configuration.damage
+                     - damage(problem, configuration.mainHand, configuration.offHand)) < 1e-9);
+        if (sameItems)
+            QVERIFY(configuration.mainHand != configuration.offHand);
+    }
+}
+
+QTEST_MAIN(tst_WeaponOptimizer)
+
+#include "tst_weaponoptimizer.moc"
@@ -0,0 +1,39 @@
+/*
+ * This file is part of Moebius Toolkit.
+ * Copyright (C) 2026 Alejandro Exojo Piqueras
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QFileInfo>
+#include <QtTest>
+
+// Like QTEST_MAIN, but unless the output is chosen in the command line, the
+// results are also written to <executable>.xml (in the QTest XML format) in the
+// current directory, so the ones of two builds can be compared with a script.
+#define MOEBIUS_BENCHMARK_MAIN(TestObject) \
+int main(int argc, char** argv) \
+{ \
+    QCoreApplication app(argc, argv); \
+    TestObject test; \
+    QStringList arguments = app.arguments(); \
+    if (!arguments.contains(QLatin1String("-o"))) { \
+        const QString name = QFileInfo(arguments.first()).completeBaseName(); \
+        arguments << QStringLiteral("-o") << name + QLatin1String(".xml,xml") \
+                  << QStringLiteral("-o") << QStringLiteral("-,txt"); \
+    } \
+    return QTest::qExec(&test, arguments); \
+}
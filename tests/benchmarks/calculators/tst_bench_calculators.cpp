@@ -0,0 +1,395 @@
+/*
+ * This file is part of Moebius Toolkit.
+ * Copyright (C) 2026 Alejandro Exojo Piqueras
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "../benchmarkmain.h"
+
+#include "backstabstats.h"
+#include "calculators.h"
+#include "damagesweep.h"
+#include "roundstokill.h"
+#include "weaponoptimizer.h"
+
+using namespace Calculators;
+
+class tst_BenchCalculators : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void hitDistribution_data();
+    void hitDistribution();
+    void hitTable_data();
+    void hitTable();
+    void averageDamages_data();
+    void averageDamages();
+    void onHitDamages_data();
+    void onHitDamages();
+    void roundDistribution_data();
+    void roundDistribution();
+    void roundsToKill_data();
+    void roundsToKill();
+    void sweep_data();
+    void sweep();
+    void optimize_data();
+    void optimize();
+    void calculateBackstab_data();
+    void calculateBackstab();
+
+private:
+    void addWeapons(bool withoutCache);
+};
+
+// A common weapon, a typical end game one, and a worst case with every kind of
+// damage, all resisted (so none of them can use the tables of the dice). With
+// a cache capacity of 0 nothing gets stored, so it's the cost from scratch.
+void tst_BenchCalculators::addWeapons(bool withoutCache)
+{
+    QTest::addColumn<WeaponArrangement>("weapon");
+    QTest::addColumn<bool>("cached");
+
+    WeaponArrangement quarterstaff;
+    quarterstaff.damage.insert(DamageType::Crushing, DiceRoll().sides(6));
+
+    WeaponArrangement varscona;
+    varscona.damage.insert(DamageType::Slashing, DiceRoll().sides(8).bonus(2));
+    varscona.damage.insert(DamageType::Cold, DiceRoll().number(0).bonus(1));
+    varscona.proficiencyToHit = 1;
+    varscona.proficiencyDamage = 2;
+    varscona.weaponToHit = 2;
+    varscona.criticalHit = 10;
+
+    WeaponArrangement everything;
+    everything.damage.insert(DamageType::Piercing,
+                             DiceRoll().number(2).sides(10).bonus(5).resistance(0.3));
+    everything.damage.insert(DamageType::Acid, DiceRoll().number(3).sides(6).resistance(0.5));
+    everything.damage.insert(DamageType::Cold, DiceRoll().number(2).sides(8).resistance(0.25));
+    everything.damage.insert(DamageType::Electricity,
+                             DiceRoll().number(4).sides(4).resistance(0.1).probability(0.5));
+    everything.damage.insert(DamageType::Fire, DiceRoll().number(5).sides(6).resistance(0.75));
+    everything.damage.insert(DamageType::MagicDamage, DiceRoll().sides(20).resistance(0.4));
+    everything.damage.insert(DamageType::PoisonDamage,
+                             DiceRoll().number(10).sides(6).resistance(0.2).probability(0.1));
+    everything.criticalHit = 20;
+    everything.criticalMiss = 0;
+
+    for (bool cached : {true, false}) {
+        if (!cached && !withoutCache)
+            break;
+        const char* suffix = cached ? "cached" : "uncached";
+        QTest::addRow("quarterstaff %s", suffix) << quarterstaff << cached;
+        QTest::addRow("varscona %s", suffix) << varscona << cached;
+        QTest::addRow("everything %s", suffix) << everything << cached;
+    }
+}
+
+void tst_BenchCalculators::hitDistribution_data()
+{
+    addWeapons(false);
+}
+
+// The whole range of armor classes of the damage calculator, for both hands.
+void tst_BenchCalculators::hitDistribution()
+{
+    QFETCH(WeaponArrangement, weapon);
+    Damage::Common common;
+    common.thac0 = 5;
+    common.statToHit = 2;
+    const Damage damage(weapon, weapon, common);
+
+    int total = 0;
+    QBENCHMARK {
+        for (int ac = 10; ac >= -20; --ac) {
+            const auto one = damage.hitDistribution(Damage::One, ac);
+            const auto two = damage.hitDistribution(Damage::Two, ac);
+            total += one.first + one.second + two.first + two.second;
+        }
+    }
+    QVERIFY(total > 0);
+}
+
+void tst_BenchCalculators::hitTable_data()
+{
+    addWeapons(false);
+}
+
+// The same as hitDistribution(), to compare looping over the rolls of each AC
+// with the table of the whole range.
+void tst_BenchCalculators::hitTable()
+{
+    QFETCH(WeaponArrangement, weapon);
+    Damage::Common common;
+    common.thac0 = 5;
+    common.statToHit = 2;
+    const Damage damage(weapon, weapon, common);
+
+    int total = 0;
+    QBENCHMARK {
+        const auto one = damage.hitTable(Damage::One, 10, -20);
+        const auto two = damage.hitTable(Damage::Two, 10, -20);
+        for (int index = 0; index < one.size(); ++index) {
+            total += one.at(index).first + one.at(index).second
+                   + two.at(index).first + two.at(index).second;
+        }
+    }
+    QVERIFY(total > 0);
+}
+
+void tst_BenchCalculators::averageDamages_data()
+{
+    addWeapons(true);
+}
+
+// What the damage calculator does for each series of the chart.
+void tst_BenchCalculators::averageDamages()
+{
+    QFETCH(WeaponArrangement, weapon);
+    QFETCH(bool, cached);
+    Damage::Common common;
+    common.thac0 = 5;
+    common.statToHit = 2;
+    const Damage damage(weapon, weapon, common);
+    Damage::Sweep sweep;
+    sweep.offHand = true;
+
+    DiceRoll::clearCache();
+    DiceRoll::setCacheCapacity(cached ? 4096 : 0);
+    double total = 0.0;
+    QBENCHMARK {
+        total += damage.averageDamages(sweep).last();
+    }
+    DiceRoll::setCacheCapacity(4096);
+    QVERIFY(total > 0.0);
+}
+
+void tst_BenchCalculators::onHitDamages_data()
+{
+    addWeapons(true);
+}
+
+void tst_BenchCalculators::onHitDamages()
+{
+    QFETCH(WeaponArrangement, weapon);
+    QFETCH(bool, cached);
+    Damage::Common common;
+    common.statDamage = 6;
+    const Damage damage(weapon, weapon, common);
+
+    DiceRoll::clearCache();
+    DiceRoll::setCacheCapacity(cached ? 4096 : 0);
+    double total = 0.0;
+    QBENCHMARK {
+        for (Damage::Stat stat : {Damage::Regular, Damage::Critical}) {
+            const auto damages = damage.onHitDamages(Damage::One, stat);
+            for (double value : damages)
+                total += value;
+        }
+    }
+    DiceRoll::setCacheCapacity(4096);
+    QVERIFY(total > 0.0);
+}
+
+void tst_BenchCalculators::roundDistribution_data()
+{
+    addWeapons(true);
+}
+
+// The whole range of armor classes of the damage calculator, with both hands
+// and a fractional number of attacks, like a chart of the distributions would.
+void tst_BenchCalculators::roundDistribution()
+{
+    QFETCH(WeaponArrangement, weapon);
+    QFETCH(bool, cached);
+    weapon.attacks = 2.5;
+    Damage::Common common;
+    common.thac0 = 5;
+    common.statDamage = 6;
+    const Damage damage(weapon, weapon, common);
+
+    DiceRoll::clearCache();
+    DiceRoll::setCacheCapacity(cached ? 4096 : 0);
+    QVector<int> armorClasses;
+    for (int ac = 10; ac >= -20; --ac)
+        armorClasses.append(ac);
+    double total = 0.0;
+    QBENCHMARK {
+        const auto one = damage.roundDistributions(Damage::One, armorClasses);
+        const auto two = damage.roundDistributions(Damage::Two, armorClasses);
+        for (int index = 0; index < armorClasses.size(); ++index)
+            total += one.at(index).convolved(two.at(index)).mean();
+    }
+    DiceRoll::setCacheCapacity(4096);
+    QVERIFY(total > 0.0);
+}
+
+void tst_BenchCalculators::roundsToKill_data()
+{
+    QTest::addColumn<int>("hitDice");
+
+    QTest::newRow("5d8+10") << 5;
+    QTest::newRow("15d8+10") << 15;
+    QTest::newRow("30d8+10") << 30;
+}
+
+// The whole range of armor classes of the damage calculator, as a chart of the
+// rounds to kill would do, from the distributions of the rounds.
+void tst_BenchCalculators::roundsToKill()
+{
+    QFETCH(int, hitDice);
+
+    WeaponArrangement weapon;
+    weapon.damage.insert(DamageType::Slashing, DiceRoll().sides(8).bonus(2));
+    weapon.damage.insert(DamageType::Cold, DiceRoll().number(0).bonus(1));
+    weapon.attacks = 2.5;
+    Damage::Common common;
+    common.thac0 = 5;
+    common.statDamage = 6;
+    const Damage damage(weapon, weapon, common);
+    const Distribution hitPoints = DiceRoll().number(hitDice).sides(8).bonus(10).distribution();
+
+    QVector<int> armorClasses;
+    for (int ac = 10; ac >= -20; --ac)
+        armorClasses.append(ac);
+    const QVector<Distribution> rounds = damage.roundDistributions(Damage::One, armorClasses);
+
+    double total = 0.0;
+    QBENCHMARK {
+        for (const Distribution& round : rounds)
+            total += RoundsToKill::calculate(round, hitPoints).mean;
+    }
+    QVERIFY(total > 0.0);
+}
+
+void tst_BenchCalculators::sweep_data()
+{
+    QTest::addColumn<int>("threads");
+
+    QTest::newRow("1 thread") << 1;
+    QTest::newRow("all cores") << 0;
+}
+
+// THAC0 20 to 0, Strength 16 to 25, all the proficiencies, 1 to 5 attacks in
+// steps of a half, against AC 10 to -20: about 350000 points.
+void tst_BenchCalculators::sweep()
+{
+    QFETCH(int, threads);
+
+    DamageSweep::Grid grid;
+    grid.weapon.damage.insert(DamageType::Slashing, DiceRoll().sides(8).bonus(2));
+    grid.weapon.damage.insert(DamageType::Cold, DiceRoll().number(0).bonus(1));
+    for (int thac0 = 20; thac0 >= 0; --thac0)
+        grid.thac0.append(thac0);
+    for (int strength = 16; strength <= 25; ++strength)
+        grid.strength.append(strength);
+    grid.proficiency = {0, 1, 2, 3, 4, 5};
+    for (double attacks = 1.0; attacks <= 5.0; attacks += 0.5)
+        grid.attacks.append(attacks);
+    grid.acFrom = 10;
+    grid.acTo = -20;
+
+    qint64 size = 0;
+    QBENCHMARK {
+        size += DamageSweep::evaluate(grid, {threads}).damage.size();
+    }
+    QVERIFY(size > 0);
+}
+
+void tst_BenchCalculators::optimize_data()
+{
+    QTest::addColumn<int>("threads");
+
+    QTest::newRow("1 thread") << 1;
+    QTest::newRow("all cores") << 0;
+}
+
+// The best 10 pairs from a catalog of 300 weapons, in either hand.
+void tst_BenchCalculators::optimize()
+{
+    QFETCH(int, threads);
+
+    const DamageType physical[] = {Crushing, Missile, Piercing, Slashing};
+    const DamageType elemental[] = {Acid, Cold, Electricity, Fire};
+    WeaponOptimizer::Problem problem;
+    for (int index = 0; index < 300; ++index) {
+        WeaponArrangement weapon;
+        weapon.damage.insert(physical[index % 4], DiceRoll().number(1 + index % 2)
+                             .sides(4 + 2 * (index % 4)).bonus(index % 5));
+        if (index % 3 == 0)
+            weapon.damage.insert(elemental[index % 4], DiceRoll().number(index % 7 / 2).sides(6));
+        weapon.weaponToHit = index % 6;
+        problem.mainHand.append(weapon);
+    }
+    problem.offHand = problem.mainHand;
+    for (WeaponArrangement& weapon : problem.offHand)
+        weapon.styleToHit = -4;
+    problem.sameItems = true;
+    problem.common.thac0 = 10;
+    problem.ac = -2;
+    problem.resistances.insert(Fire, 0.3);
+
+    DiceRoll::clearCache();
+    double total = 0.0;
+    QBENCHMARK {
+        total += WeaponOptimizer::optimize(problem, {threads}).best.constFirst().damage;
+    }
+    QVERIFY(total > 0.0);
+}
+
+void tst_BenchCalculators::calculateBackstab_data()
+{
+    QTest::addColumn<WeaponArrangement>("weapon");
+    QTest::addColumn<int>("multiplier");
+
+    WeaponArrangement dagger;
+    dagger.damage.insert(DamageType::Piercing, DiceRoll().sides(4));
+    QTest::newRow("dagger x2") << dagger << 2;
+    WeaponArrangement shortSword;
+    shortSword.damage.insert(DamageType::Piercing, DiceRoll().sides(6).bonus(2));
+    QTest::newRow("short sword +2 x5") << shortSword << 5;
+    WeaponArrangement katana;
+    katana.damage.insert(DamageType::Slashing, DiceRoll().sides(10).bonus(3).luck(2));
+    katana.damage.insert(DamageType::Fire, DiceRoll().number(2).sides(6));
+    katana.proficiencyDamage = 2;
+    QTest::newRow("katana x7 luck, fire") << katana << 7;
+}
+
+// All the multipliers and kit bonuses, as many setups as a busy backstab page.
+void tst_BenchCalculators::calculateBackstab()
+{
+    QFETCH(WeaponArrangement, weapon);
+    QFETCH(int, multiplier);
+
+    double total = 0.0;
+    QBENCHMARK {
+        for (int m = 1; m <= multiplier; ++m) {
+            for (int kit = 0; kit <= 3; ++kit) {
+                Backstab::Other other;
+                other.multiplier = m;
+                other.kit = kit;
+                other.bonus = 1;
+                other.strength = 3;
+                const BackstabResult result = ::calculateBackstab(Backstab(weapon, other));
+                total += result.mean + result.percentile(0.9);
+            }
+        }
+    }
+    QVERIFY(total > 0.0);
+}
+
+MOEBIUS_BENCHMARK_MAIN(tst_BenchCalculators)
+
+#include "tst_bench_calculators.moc"
@@ -0,0 +1,12 @@
+TEMPLATE = app
+TARGET = tst_bench_diceroll
+
+QT = core testlib
+CONFIG += testcase benchmark no_testcase_installs
+CONFIG -= app_bundle
+
+projectGlobals()
+useLibMoebius()
+
+SOURCES += tst_bench_diceroll.cpp
+
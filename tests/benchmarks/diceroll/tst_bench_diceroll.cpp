@@ -0,0 +1,294 @@
+/*
+ * This file is part of Moebius Toolkit.
+ * Copyright (C) 2026 Alejandro Exojo Piqueras
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "../benchmarkmain.h"
+
+#include "diceroll.h"
+#include "dicerollbatch.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <vector>
+
+// Count every allocation in the process, so the benchmarks can report how
+// many happen while visiting the outcomes of a roll, and not only the time.
+// QVector allocates with malloc (and operator new ends up there too), so the
+// C functions are the ones replaced, forwarding to the glibc implementation.
+static std::atomic<qint64> allocations = 0;
+
+#if defined(__GLIBC__)
+#define COUNTING_ALLOCATIONS
+
+extern "C" {
+
+void* __libc_malloc(std::size_t size);
+void* __libc_calloc(std::size_t count, std::size_t size);
+void* __libc_realloc(void* pointer, std::size_t size);
+
+void* malloc(std::size_t size) noexcept
+{
+    ++allocations;
+    return __libc_malloc(size);
+}
+
+void* calloc(std::size_t count, std::size_t size) noexcept
+{
+    ++allocations;
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* pointer, std::size_t size) noexcept
+{
+    ++allocations;
+    return __libc_realloc(pointer, size);
+}
+
+}
+#endif
+
+class tst_BenchDiceRoll : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void average_data();
+    void average();
+    void sigma_data();
+    void sigma();
+    void permutations_data();
+    void permutations();
+    void outcomes_data();
+    void outcomes();
+    void permutationsAllocations_data();
+    void permutationsAllocations();
+    void outcomesAllocations_data();
+    void outcomesAllocations();
+    void sweep_data();
+    void sweep();
+
+private:
+    void addRolls();
+    void addStatisticsRolls();
+};
+
+void tst_BenchDiceRoll::addRolls()
+{
+    QTest::addColumn<DiceRoll>("roll");
+
+    QTest::newRow("1d8")  << DiceRoll().sides(8);
+    QTest::newRow("2d6")  << DiceRoll().number(2).sides(6);
+    QTest::newRow("4d6")  << DiceRoll().number(4).sides(6);
+    QTest::newRow("6d6")  << DiceRoll().number(6).sides(6);
+    QTest::newRow("7d6")  << DiceRoll().number(7).sides(6);
+}
+
+// From the weapons in the game, to big spells with resistance as worst case.
+// Each one with and without the cache, which can't store anything if the
+// capacity is 0, so the second gives the cost of calculating from scratch.
+void tst_BenchDiceRoll::addStatisticsRolls()
+{
+    QTest::addColumn<DiceRoll>("roll");
+    QTest::addColumn<bool>("cached");
+
+    const struct {
+        const char* name;
+        DiceRoll roll;
+    } rolls[] = {
+        {"1d8+1", DiceRoll().sides(8).bonus(1)},
+        {"2d6+3@+2", DiceRoll().number(2).sides(6).bonus(3).luck(2)},
+        {"1d10+4 r=0.1", DiceRoll().sides(10).bonus(4).resistance(0.1)},
+        {"4d6 50%", DiceRoll().number(4).sides(6).probability(0.5)},
+        {"10d6 r=0.5", DiceRoll().number(10).sides(6).resistance(0.5)},
+        {"20d20@-3 r=0.25", DiceRoll().number(20).sides(20).luck(-3).resistance(0.25)},
+    };
+    for (const auto& [name, roll] : rolls) {
+        for (bool cached : {true, false})
+            QTest::addRow("%s %s", name, cached ? "cached" : "uncached") << roll << cached;
+    }
+}
+
+void tst_BenchDiceRoll::average_data()
+{
+    addStatisticsRolls();
+}
+
+void tst_BenchDiceRoll::average()
+{
+    QFETCH(DiceRoll, roll);
+    QFETCH(bool, cached);
+
+    DiceRoll::clearCache();
+    DiceRoll::setCacheCapacity(cached ? 4096 : 0);
+    double result = 0.0;
+    QBENCHMARK {
+        result = roll.average();
+    }
+    DiceRoll::setCacheCapacity(4096);
+    QVERIFY(result > 0.0);
+}
+
+void tst_BenchDiceRoll::sigma_data()
+{
+    addStatisticsRolls();
+}
+
+void tst_BenchDiceRoll::sigma()
+{
+    QFETCH(DiceRoll, roll);
+    QFETCH(bool, cached);
+
+    DiceRoll::clearCache();
+    DiceRoll::setCacheCapacity(cached ? 4096 : 0);
+    double result = 0.0;
+    QBENCHMARK {
+        result = roll.sigma();
+    }
+    DiceRoll::setCacheCapacity(4096);
+    QVERIFY(result > 0.0);
+}
+
+void tst_BenchDiceRoll::permutations_data()
+{
+    addRolls();
+}
+
+void tst_BenchDiceRoll::permutations()
+{
+    QFETCH(DiceRoll, roll);
+    qint64 total = 0;
+    QBENCHMARK {
+        for (const QVector<int>& rolls : roll.permutations())
+            total += rolls.last();
+    }
+    QVERIFY(total > 0);
+}
+
+void tst_BenchDiceRoll::outcomes_data()
+{
+    addRolls();
+}
+
+void tst_BenchDiceRoll::outcomes()
+{
+    QFETCH(DiceRoll, roll);
+    qint64 total = 0;
+    QBENCHMARK {
+        for (const QVector<int>& rolls : roll.outcomes())
+            total += rolls.last();
+    }
+    QVERIFY(total > 0);
+}
+
+void tst_BenchDiceRoll::permutationsAllocations_data()
+{
+    addRolls();
+}
+
+void tst_BenchDiceRoll::permutationsAllocations()
+{
+#ifndef COUNTING_ALLOCATIONS
+    QSKIP("Counting the allocations needs glibc");
+#endif
+    QFETCH(DiceRoll, roll);
+    const qint64 before = allocations;
+    qint64 total = 0;
+    for (const QVector<int>& rolls : roll.permutations())
+        total += rolls.last();
+    QTest::setBenchmarkResult(allocations - before, QTest::Events);
+    QVERIFY(total > 0);
+}
+
+void tst_BenchDiceRoll::outcomesAllocations_data()
+{
+    addRolls();
+}
+
+void tst_BenchDiceRoll::outcomesAllocations()
+{
+#ifndef COUNTING_ALLOCATIONS
+    QSKIP("Counting the allocations needs glibc");
+#endif
+    QFETCH(DiceRoll, roll);
+    const qint64 before = allocations;
+    qint64 total = 0;
+    for (const QVector<int>& rolls : roll.outcomes())
+        total += rolls.last();
+    const qint64 allocated = allocations - before;
+    QTest::setBenchmarkResult(allocated, QTest::Events);
+    QVERIFY(total > 0);
+    // Only the buffers of the range and the iterator, whatever the roll size.
+    QVERIFY(allocated <= 3);
+}
+
+void tst_BenchDiceRoll::sweep_data()
+{
+    QTest::addColumn<bool>("batch");
+    QTest::newRow("objects") << false;
+    QTest::newRow("batch") << true;
+}
+
+// The statistics of all the rolls of many weapons and enemies (thousands of
+// combinations of dice, bonus and luck), one DiceRoll at a time or in a batch.
+void tst_BenchDiceRoll::sweep()
+{
+    QFETCH(bool, batch);
+
+    std::vector<int> number, sides, bonus, luck;
+    std::vector<double> resistance, probability;
+    for (int n = 1; n <= 10; ++n) {
+        for (int s : {2, 3, 4, 5, 6, 8, 10, 12, 20}) {
+            for (int b = -2; b <= 8; ++b) {
+                for (int l = -5; l <= 5; ++l) {
+                    number.push_back(n);
+                    sides.push_back(s);
+                    bonus.push_back(b);
+                    luck.push_back(l);
+                    resistance.push_back(0.0);
+                    probability.push_back(1.0);
+                }
+            }
+        }
+    }
+
+    const std::size_t size = number.size();
+    std::vector<double> average(size), sigma(size);
+    std::vector<int> minimum(size), maximum(size);
+    QBENCHMARK {
+        if (batch) {
+            DiceRollBatch::evaluate({number, sides, bonus, luck, resistance, probability},
+                                    {average, sigma, minimum, maximum});
+        }
+        else {
+            for (std::size_t row = 0; row < size; ++row) {
+                const auto roll = DiceRoll().number(number[row]).sides(sides[row])
+                                            .bonus(bonus[row]).luck(luck[row])
+                                            .resistance(resistance[row])
+                                            .probability(probability[row]);
+                average[row] = roll.average();
+                sigma[row] = roll.sigma();
+                minimum[row] = roll.minimum();
+                maximum[row] = roll.maximum();
+            }
+        }
+    }
+    QVERIFY(average.back() > 0.0);
+}
+
+MOEBIUS_BENCHMARK_MAIN(tst_BenchDiceRoll)
+
+#include "tst_bench_diceroll.moc"
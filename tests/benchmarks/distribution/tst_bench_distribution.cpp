@@ -0,0 +1,181 @@
+/*
+ * This file is part of Moebius Toolkit.
+ * Copyright (C) 2026 Alejandro Exojo Piqueras
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "../benchmarkmain.h"
+
+#include "diceroll.h"
+#include "distribution.h"
+#include "distributionkernels.h"
+
+class tst_BenchDistribution : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void convolve_data();
+    void convolve();
+    void accumulate_data();
+    void accumulate();
+    void power_data();
+    void power();
+    void resistance_data();
+    void resistance();
+};
+
+// Same rows for scalar and native, so each pair of lines in the output is the
+// comparison of the two for the same dice.
+static void addRows()
+{
+    QTest::addColumn<bool>("native");
+    QTest::addColumn<int>("number");
+    QTest::addColumn<int>("sides");
+
+    const QVector<QPair<int, int>> rolls = {
+        {1, 6}, {2, 6}, {10, 6}, {4, 8}, {10, 10}, {20, 6}, {20, 20}
+    };
+    for (const auto& [number, sides] : rolls) {
+        for (bool native : {false, true}) {
+            QTest::addRow("%dd%d %s", number, sides, native ? "native" : "scalar")
+                    << native << number << sides;
+        }
+    }
+}
+
+void tst_BenchDistribution::convolve_data()
+{
+    addRows();
+}
+
+// Full NdS distribution, convolving one dice at a time.
+void tst_BenchDistribution::convolve()
+{
+    QFETCH(bool, native);
+    QFETCH(int, number);
+    QFETCH(int, sides);
+
+    const auto& kernels = native ? DistributionKernels::native()
+                                 : DistributionKernels::scalar();
+    const QVector<double> oneDice(sides, 1.0 / sides);
+    QVector<double> sum;
+    QVector<double> next;
+
+    QBENCHMARK {
+        sum = {1.0};
+        for (int dice = 0; dice < number; ++dice) {
+            next.fill(0.0, sum.size() + sides - 1);
+            kernels.convolve(oneDice.constData(), sides, sum.constData(), sum.size(),
+                             next.data());
+            sum.swap(next);
+        }
+    }
+    QCOMPARE(sum.size(), number * (sides - 1) + 1);
+}
+
+void tst_BenchDistribution::accumulate_data()
+{
+    addRows();
+}
+
+// Mixing the full NdS distribution with another of the same size.
+void tst_BenchDistribution::accumulate()
+{
+    QFETCH(bool, native);
+    QFETCH(int, number);
+    QFETCH(int, sides);
+
+    const auto& kernels = native ? DistributionKernels::native()
+                                 : DistributionKernels::scalar();
+    const int size = number * (sides - 1) + 1;
+    const QVector<double> input(size, 1.0 / size);
+    QVector<double> output(size, 0.0);
+
+    QBENCHMARK {
+        kernels.accumulate(output.data(), input.constData(), size, 0.25);
+        kernels.scale(output.data(), size, 0.5);
+    }
+    QVERIFY(output.first() > 0.0);
+}
+
+void tst_BenchDistribution::power_data()
+{
+    QTest::addColumn<int>("number");
+    QTest::addColumn<int>("sides");
+
+    const QVector<QPair<int, int>> rolls = {
+        {10, 6}, {20, 6}, {15, 8}, {40, 4}, {20, 20}, {40, 20}, {100, 6}
+    };
+    for (const auto& [number, sides] : rolls)
+        QTest::addRow("%dd%d", number, sides) << number << sides;
+}
+
+// The whole Distribution::power(), which switches to the FFT for big pools.
+void tst_BenchDistribution::power()
+{
+    QFETCH(int, number);
+    QFETCH(int, sides);
+
+    const Distribution oneDice(1, QVector<double>(sides, 1.0 / sides));
+    Distribution sum;
+    QBENCHMARK {
+        sum = oneDice.power(number);
+    }
+    QCOMPARE(sum.size(), number * (sides - 1) + 1);
+}
+
+void tst_BenchDistribution::resistance_data()
+{
+    QTest::addColumn<bool>("table");
+    QTest::addColumn<int>("number");
+    QTest::addColumn<int>("sides");
+
+    const QVector<QPair<int, int>> rolls = {{1, 8}, {2, 6}, {10, 6}, {20, 20}, {100, 6}};
+    for (const auto& [number, sides] : rolls) {
+        for (bool table : {false, true}) {
+            QTest::addRow("%dd%d %s", number, sides, table ? "table" : "per value")
+                    << table << number << sides;
+        }
+    }
+}
+
+// The resistance of an enemy going from 0% to 100%, applied to the same dice.
+// Per value calls the rounding function for each one (what mapped() does),
+// while the table path precomputes it, and remapped() only does lookups.
+void tst_BenchDistribution::resistance()
+{
+    QFETCH(bool, table);
+    QFETCH(int, number);
+    QFETCH(int, sides);
+
+    const Distribution dice = Distribution(1, QVector<double>(sides, 1.0 / sides)).power(number);
+    const auto roll = DiceRoll().number(number).sides(sides);
+    double total = 0.0;
+    QBENCHMARK {
+        for (int percent = 0; percent <= 100; percent += 5) {
+            const auto resisted = roll.resistance(percent / 100.0);
+            const Distribution result = table
+                    ? dice.remapped(resisted.resistanceTable())
+                    : dice.mapped([&resisted](int value) { return resisted.resistified(value); });
+            total += result.probability(result.first());
+        }
+    }
+    QVERIFY(total > 0.0);
+}
+
+MOEBIUS_BENCHMARK_MAIN(tst_BenchDistribution)
+
+#include "tst_bench_distribution.moc"